@@ -0,0 +1,342 @@
+/*!
+  @file       awaitable.hpp
+  @brief      C++20 coroutine awaitables for Subject and Numeric
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Pulled in by subject.hpp when the compiler supports coroutines; provides
+    co_await subject.next()                      -> the notification's arguments
+    co_await numeric.when( [](T v){ ... } )      -> first value satisfying the predicate
+    auto s = numeric.changes() ;  co_await s.next()  -> every value, in order
+
+  A suspended coroutine costs one small one-shot observer on the subject and no
+  thread.  It is resumed from the dispatch path, inside the notifying invoke,
+  unless an Executor is given, in which case the handle is passed to it instead.
+  The subject must outlive any coroutine suspended on it; a coroutine may be
+  destroyed while suspended, and its observer then expires on the next
+  notification without touching the freed frame.
+*/
+#pragma once
+
+#include "boost/observe/subject.hpp"
+
+#ifdef BOOST_OBSERVERS_HAS_COROUTINES
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+
+namespace boost { namespace observables {
+
+// shared by a one-shot awaiter and its observer; the awaiter clears alive
+// when it is destroyed, with or without having been resumed
+struct AwaitLink
+{
+  LockFreeMutex              lock ;
+  bool                       alive ;
+} ;
+
+/*!
+  @class AwaitObserver
+
+  <b>Description:</b>
+  one-shot observer behind every awaiter.  Accept inspects the notification,
+  copies out what the awaiter wants, and returns true to wake the coroutine.
+  the observer then expires and its Subject deletes it after the dispatch.
+  Accept runs under the link's lock, so the awaiter it writes into cannot be
+  destroyed meanwhile; once the link is dead the observer just expires.
+*/
+template <class Accept>
+class AwaitObserver : public boost::observers::Observer
+{
+  protected :
+    Accept                   _accept ;
+    std::coroutine_handle<>  _h ;
+    Executor                 _exec ;
+    std::shared_ptr<AwaitLink>  _link ;
+
+  public    :
+                             AwaitObserver( Accept a, std::coroutine_handle<> h, const Executor &e,
+                                            const std::shared_ptr<AwaitLink> &link )
+                             : _accept( a ), _h( h ), _exec( e ), _link( link )
+                             {}
+
+    virtual int              invoke() { return invoke( std::vector<boost::any>() ) ; }
+    virtual int              invoke( const std::vector<boost::any> &args )
+                             {
+                               if (!_enabled)
+                                 return 0 ;
+                               {
+                                 lock_guard<LockFreeMutex>  sc( _link->lock ) ;
+                                 if (_link->alive)
+                                 {
+                                   if (!_accept( args ))
+                                     return 0 ;
+                                   _link->alive = false ;
+                                 }
+                                 else
+                                 {
+                                   expire() ;     // the coroutine was destroyed while suspended
+                                   return 0 ;
+                                 }
+                               }
+                               expire() ;
+                               std::coroutine_handle<>  h = _h ;
+                               if (_exec)
+                                 _exec( h ) ;
+                               else
+                                 h.resume() ;   // may destroy the awaiter; don't touch it after this
+                               return 0 ;
+                             }
+    virtual const char      *kind() const { return "AwaitObserver" ; }
+} ; // class AwaitObserver
+
+template <class Accept>
+inline boost::observers::Observer *make_await_observer( Accept a, std::coroutine_handle<> h, const Executor &e,
+                                                        const std::shared_ptr<AwaitLink> &link )
+{
+  return new AwaitObserver<Accept>( a, h, e, link ) ;
+} // :: make_await_observer
+
+/*!
+  @class LinkedAwaiter
+
+  <b>Description:</b>
+  base of the one-shot awaiters: owns the AwaitLink their observer checks
+  before touching them, and kills it on destruction.
+*/
+class LinkedAwaiter
+{
+  protected :
+    std::shared_ptr<AwaitLink>  _link ;
+
+    const std::shared_ptr<AwaitLink>  &_attach()
+                             {
+                               _link        = std::make_shared<AwaitLink>() ;
+                               _link->alive = true ;
+                               return _link ;
+                             }
+
+  public    :
+                             LinkedAwaiter() {}
+                             LinkedAwaiter( const LinkedAwaiter & ) {}    // a copy is not attached
+                            ~LinkedAwaiter()
+                             {
+                               if (_link)
+                               {
+                                 lock_guard<LockFreeMutex>  sc( _link->lock ) ;
+                                 _link->alive = false ;
+                               }
+                             }
+} ; // class LinkedAwaiter
+
+/*!
+  @class NextAwaiter
+
+  <b>Description:</b>
+  result of Subject::next(); resumes with a copy of the next notification's
+  arguments (empty for a plain invoke()).
+*/
+class NextAwaiter : public LinkedAwaiter
+{
+  private   :
+    Subject                 &_subj ;
+    Executor                 _exec ;
+    std::vector<boost::any>  _args ;
+
+  public    :
+                             NextAwaiter( Subject &s, const Executor &e ) : _subj( s ), _exec( e ) {}
+
+    bool                     await_ready() const { return false ; }
+    void                     await_suspend( std::coroutine_handle<> h )
+                             {
+                               _subj.install( make_await_observer( [this]( const std::vector<boost::any> &args ) {
+                                 _args = args ;
+                                 return true ;
+                               }, h, _exec, _attach() )) ;
+                             }
+    std::vector<boost::any>  await_resume() { return std::move( _args ) ; }
+} ; // class NextAwaiter
+
+template <> inline NextAwaiter Subject::next() { return NextAwaiter( *this, Executor() ) ; }
+template <> inline NextAwaiter Subject::next( const Executor &e ) { return NextAwaiter( *this, e ) ; }
+
+/*!
+  @class ValueAwaiter< T, Pred >
+
+  <b>Description:</b>
+  result of Numeric::when( pred ).  ready at once if the current value already
+  satisfies pred; otherwise resumes with the first new value that does.  the
+  check and the install happen under the subject lock, the same lock the
+  Numeric setters take, so a change cannot slip between them.
+*/
+template <class T, class Pred>
+class ValueAwaiter : public LinkedAwaiter
+{
+  private   :
+    Subject                 &_subj ;
+    const std::atomic<T>    &_x ;
+    Pred                     _pred ;
+    Executor                 _exec ;
+    T                        _value ;
+
+  public    :
+                             ValueAwaiter( Subject &s, const std::atomic<T> &x, Pred p, const Executor &e )
+                             : _subj( s ), _x( x ), _pred( p ), _exec( e ), _value( x.load() )
+                             {}
+
+    bool                     await_ready() { return _pred( _value ) ; }
+    bool                     await_suspend( std::coroutine_handle<> h )
+                             {
+#ifdef BOOST_HAS_THREADS
+                               lock_guard<LockFreeMutex>  sc( _subj.lock() ) ;
+#endif
+                               _value = _x.load() ;
+                               if (_pred( _value ))
+                                 return false ;
+                               _subj.install( make_await_observer( [this]( const std::vector<boost::any> &args ) {
+                                 T  v = boost::any_cast<T>( args[0] ) ;
+                                 if (!_pred( v ))
+                                   return false ;
+                                 _value = v ;
+                                 return true ;
+                               }, h, _exec, _attach() )) ;
+                               return true ;
+                             }
+    T                        await_resume() const { return _value ; }
+} ; // class ValueAwaiter
+
+/*!
+  @class ChangeStream< T >
+
+  <b>Description:</b>
+  result of Numeric::changes().  queues every new value from the moment it is
+  created; co_await next() hands them out in order, suspending while the queue
+  is empty.  max_backlog > 0 bounds the queue by dropping the oldest values.
+
+  <b>Notes:</b>
+  C++20 has no 'for co_await', so consume it with a loop:
+    auto s = price.changes() ;
+    for (;;) { double v = co_await s.next() ; ... }
+  destroying the stream detaches it; its observer expires on the next change.
+*/
+template <class T>
+class ChangeStream
+{
+  private   :
+    struct _State
+    {
+      LockFreeMutex              lock ;
+      std::deque<T>              q ;
+      std::coroutine_handle<>    waiter ;
+      Executor                   exec ;
+      size_t                     max_backlog ;
+      bool                       closed ;
+    } ;
+
+    class _Tap : public boost::observers::Observer
+    {
+      protected :
+        std::shared_ptr<_State>  _st ;
+
+      public    :
+                                 _Tap( const std::shared_ptr<_State> &st ) : _st( st ) {}
+
+        virtual int              invoke() { return 0 ; }
+        virtual int              invoke( const std::vector<boost::any> &args )
+                                 {
+                                   std::coroutine_handle<>  h ;
+                                   {
+                                     lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                     if (_st->closed)
+                                     {
+                                       expire() ;
+                                       return 0 ;
+                                     }
+                                     _st->q.push_back( boost::any_cast<T>( args[0] ) ) ;
+                                     if ((_st->max_backlog != 0) && (_st->q.size() > _st->max_backlog))
+                                       _st->q.pop_front() ;
+                                     h = _st->waiter ;
+                                     _st->waiter = nullptr ;
+                                   }
+                                   if (h)
+                                   {
+                                     if (_st->exec)
+                                       _st->exec( h ) ;
+                                     else
+                                       h.resume() ;
+                                   }
+                                   return 0 ;
+                                 }
+        virtual const char      *kind() const { return "ChangeStream" ; }
+    } ; // class _Tap
+
+    std::shared_ptr<_State>      _st ;
+
+  public    :
+    class NextValue
+    {
+      private   :
+        std::shared_ptr<_State>  _st ;
+
+      public    :
+                                 NextValue( const std::shared_ptr<_State> &st ) : _st( st ) {}
+
+        bool                     await_ready()
+                                 {
+                                   lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                   return !_st->q.empty() ;
+                                 }
+        bool                     await_suspend( std::coroutine_handle<> h )
+                                 {
+                                   lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                   if (!_st->q.empty())
+                                     return false ;
+                                   _st->waiter = h ;
+                                   return true ;
+                                 }
+        T                        await_resume()
+                                 {
+                                   lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                   T  v = _st->q.front() ;
+                                   _st->q.pop_front() ;
+                                   return v ;
+                                 }
+    } ; // class NextValue
+
+                                 ChangeStream( Subject &s, size_t max_backlog, const Executor &e )
+                                 : _st( std::make_shared<_State>() )
+                                 {
+                                   _st->exec        = e ;
+                                   _st->max_backlog = max_backlog ;
+                                   _st->closed      = false ;
+                                   s.install( new _Tap( _st )) ;
+                                 }
+                                 ChangeStream( ChangeStream &&o ) : _st( std::move( o._st )) {}
+                                 ChangeStream( const ChangeStream & ) = delete ;
+                                ~ChangeStream()
+                                 {
+                                   if (_st)
+                                   {
+                                     lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                     _st->closed = true ;
+                                     _st->waiter = nullptr ;
+                                   }
+                                 }
+
+    NextValue                    next() { return NextValue( _st ) ; }
+    size_t                       backlog()
+                                 {
+                                   lock_guard<LockFreeMutex>  sc( _st->lock ) ;
+                                   return _st->q.size() ;
+                                 }
+} ; // class ChangeStream
+
+}} ; // namespace
+
+#endif // BOOST_OBSERVERS_HAS_COROUTINES
@@ -0,0 +1,159 @@
+/*!
+  @file       broadcast.hpp
+  @brief      BroadcastSubject class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "boost/observe/subject.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class BroadcastSubject
+
+  <b>Description:</b>
+  a Subject whose observers are partitioned into lanes, one per worker thread
+  (or core).  invoke() wraps the arguments once and posts a pointer into the
+  lock-free inbox of every lane that has observers, so the publisher's cost is
+  O(lanes) instead of O(observers).  each worker calls drain() on its own lane,
+  which runs only the observers homed there, on that worker's thread.
+
+  <b>Notes:</b>
+  each inbox is a single-producer/single-consumer ring.  concurrent publishers
+  are serialized on a gate; a lane must only be drained by one thread.  when an
+  inbox is full the publisher yields until its worker catches up.
+*/
+class BroadcastSubject
+{
+  private   :
+    typedef std::shared_ptr< const std::vector<boost::any> >   _Msg ;
+
+    struct alignas(64) _Lane
+    {
+      std::vector<_Msg>              ring ;
+      std::vector<uint8_t>           has_args ;
+      alignas(64) std::atomic<uint64_t>  head ;     // next slot to publish (publisher)
+      alignas(64) std::atomic<uint64_t>  tail ;     // next slot to drain (worker)
+      alignas(64) Subject            local ;        // observers homed on this lane
+
+                                     _Lane( size_t depth, void *src )
+                                     : ring( depth ), has_args( depth, 0 ), head( 0 ), tail( 0 ), local( src )
+                                     {}
+    } ;
+
+#ifdef BOOST_HAS_THREADS
+    LockFreeMutex                    _lock ;        // serializes publishers
+#endif
+    std::vector< std::unique_ptr<_Lane> >  _lanes ;
+    uint64_t                         _mask ;
+
+    static size_t                   &_home() { static thread_local size_t lane = 0 ; return lane ; }
+    static size_t                    _pow2( size_t n )
+                                     {
+                                       size_t  p = 1 ;
+                                       while (p < n)  p <<= 1 ;
+                                       return p ;
+                                     }
+    void                             _post( const _Msg &m, bool has_args )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+#endif
+                                       for (auto &l : _lanes)
+                                       {
+                                         if (l->local.nWatchers() == 0)
+                                           continue ;
+
+                                         uint64_t  h = l->head.load( std::memory_order_relaxed ) ;
+                                         while (h - l->tail.load( std::memory_order_acquire ) > _mask)
+                                           std::this_thread::yield() ;   // inbox full; let the worker catch up
+
+                                         l->ring[ h & _mask ]     = m ;
+                                         l->has_args[ h & _mask ] = has_args ;
+                                         l->head.store( h + 1, std::memory_order_release ) ;
+                                       }
+                                     }
+
+  public    :
+                                     BroadcastSubject( size_t n_lanes = std::thread::hardware_concurrency(), size_t depth = 1024, void *src_ = nullptr )
+                                     {
+                                       if (n_lanes == 0)  n_lanes = 1 ;
+                                       depth = _pow2( depth ) ;
+                                       _mask = depth - 1 ;
+                                       for (size_t i = 0; i < n_lanes; i++)
+                                         _lanes.emplace_back( new _Lane( depth, (src_ != nullptr) ? src_ : this ) ) ;
+                                     }
+
+    // the lane install( o ) uses for observers created on the calling thread
+    static void                      set_home_lane( size_t lane ) { _home() = lane ; }
+    static size_t                    home_lane() { return _home() ; }
+
+    boost::observers::Observer      *install( boost::observers::Observer *o, size_t lane )
+                                     {
+                                       return _lanes[ lane % _lanes.size() ]->local.install( o ) ;
+                                     }
+    boost::observers::Observer      *install( boost::observers::Observer *o ) { return install( o, home_lane() ) ; }
+    boost::observers::Observer      *remove( boost::observers::Observer *o, size_t lane )
+                                     {
+                                       return _lanes[ lane % _lanes.size() ]->local.remove( o ) ;
+                                     }
+    BroadcastSubject                &operator<< ( boost::observers::Observer *o ) { if (o) install( o ) ; return *this ; }
+
+    void                             invoke() { _post( _Msg(), false ) ; }
+    void                             invoke( const std::vector<boost::any> &args )
+                                     {
+                                       _post( std::make_shared< const std::vector<boost::any> >( args ), true ) ;
+                                     }
+
+    // runs the lane's observers for up to max pending notifications; returns how many ran
+    size_t                           drain( size_t lane, size_t max = SIZE_MAX )
+                                     {
+                                       _Lane    &l = *_lanes[ lane % _lanes.size() ] ;
+                                       uint64_t  t = l.tail.load( std::memory_order_relaxed ) ;
+                                       uint64_t  h = l.head.load( std::memory_order_acquire ) ;
+                                       size_t    n = 0 ;
+
+                                       for ( ; (t != h) && (n < max); t++, n++)
+                                       {
+                                         _Msg  m = std::move( l.ring[ t & _mask ] ) ;
+                                         bool  a = l.has_args[ t & _mask ] != 0 ;
+                                         l.tail.store( t + 1, std::memory_order_release ) ;   // slot free before we run
+                                         if (a)
+                                           l.local.invoke( *m ) ;
+                                         else
+                                           l.local.invoke() ;
+                                       }
+                                       return n ;
+                                     }
+    size_t                           drain() { return drain( home_lane() ) ; }
+
+    // access methods
+    size_t                           nLanes() const { return _lanes.size() ; }
+    size_t                           pending( size_t lane ) const
+                                     {
+                                       const _Lane &l = *_lanes[ lane % _lanes.size() ] ;
+                                       return (size_t)(l.head.load( std::memory_order_acquire ) - l.tail.load( std::memory_order_acquire )) ;
+                                     }
+    Subject                         &lane( size_t n ) { return _lanes[ n % _lanes.size() ]->local ; }
+    size_t                           nWatchers() const
+                                     {
+                                       size_t  n = 0 ;
+                                       for (auto &l : _lanes)
+                                         n += l->local.nWatchers() ;
+                                       return n ;
+                                     }
+} ; // class BroadcastSubject
+
+}} ; // namespace
@@ -0,0 +1,110 @@
+/*!
+  @file       cursor.hpp
+  @brief      ChangeCursor class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+namespace boost { namespace observables {
+
+/*!
+  @class ChangeCursor
+
+  <b>Description:</b>
+  "did anything change since I last looked?" over many sources at once, for
+  pollers (a render loop, a risk sweep) that want no callbacks.  a source is
+  anything with a version_counter(): Subject, Numeric, oMap, oVector.
+
+  changed() is one pass: the counters are read into a flat array, then
+  xor-compared with the versions last seen in a loop the compiler
+  vectorizes.  poll( f ) calls f( i ) for each source that moved, in the
+  order added, and takes the new versions as seen.
+
+  <b>Notes:</b>
+  sources must outlive the cursor.  a version says that something changed,
+  not what or how often; read the source itself for that.  one cursor per
+  polling thread.
+*/
+class ChangeCursor
+{
+  private   :
+    std::vector<const std::atomic<uint64_t> *>  _src ;
+    std::vector<uint64_t>            _seen ;
+    std::vector<uint64_t>            _now ;
+
+    void                             _load()
+                                     {
+                                       const std::atomic<uint64_t> *const *s = _src.data() ;
+                                       uint64_t  *now = _now.data() ;
+                                       for (size_t i = 0, n = _src.size(); i < n; i++)
+                                         now[ i ] = s[ i ]->load( std::memory_order_acquire ) ;
+                                     }
+    bool                             _differ() const
+                                     {
+                                       const uint64_t  *now  = _now.data() ;
+                                       const uint64_t  *seen = _seen.data() ;
+                                       uint64_t  d = 0 ;
+                                       for (size_t i = 0, n = _now.size(); i < n; i++)
+                                         d |= now[ i ] ^ seen[ i ] ;
+                                       return d != 0 ;
+                                     }
+
+  public    :
+    // returns the source's index; its current version counts as seen
+    size_t                           add( const std::atomic<uint64_t> &v )
+                                     {
+                                       _src.push_back( &v ) ;
+                                       _seen.push_back( v.load( std::memory_order_acquire ) ) ;
+                                       _now.push_back( _seen.back() ) ;
+                                       return _src.size() - 1 ;
+                                     }
+    template <class S>
+    size_t                           add( S &s ) { return add( s.version_counter() ) ; }
+
+    // true if any source moved since the last poll(); nothing is marked seen
+    bool                             changed()
+                                     {
+                                       _load() ;
+                                       return _differ() ;
+                                     }
+    // f( size_t i ) for each source that moved; returns how many did
+    template <class F>
+    size_t                           poll( F f )
+                                     {
+                                       if (!changed())
+                                         return 0 ;
+                                       size_t  n = 0 ;
+                                       for (size_t i = 0; i < _now.size(); i++)
+                                       {
+                                         if (_now[ i ] != _seen[ i ])
+                                         {
+                                           _seen[ i ] = _now[ i ] ;
+                                           f( i ) ;
+                                           n++ ;
+                                         }
+                                       }
+                                       return n ;
+                                     }
+    // takes everything as seen without reporting it
+    void                             sync()
+                                     {
+                                       _load() ;
+                                       _seen = _now ;
+                                     }
+
+    // access methods
+    size_t                           size() const { return _src.size() ; }
+    uint64_t                         seen( size_t i ) const { return _seen[ i ] ; }
+} ; // class ChangeCursor
+
+}} ; // namespace
@@ -12,21 +12,32 @@
 #pragma once
 
 #include "boost/observe/subject.hpp"
+#include <algorithm>
 #include <map>
+#include <numeric>
+#include <vector>
 
 namespace boost { namespace observables {
 
-template <class T>
+template <class T, class _Gate = LockFreeMutex>
 class EventMap
 {
+  public  :
+    typedef basic_subject< _Gate >                       Subject ;
+
+    // one entry of a batch; dispatched as { id, args... } like invoke( id, args )
+    struct Event
+    {
+      T                                 id ;
+      std::vector<boost::any>           args ;
+    } ;
+
   private :
     typedef typename std::map< T, Subject >              _EventMap ;
     typedef typename std::map< T, Subject >::iterator    _EventMap_iter ;
     typedef typename std::map< T, Subject >::value_type  _EventMap_pair ;
 
-#ifdef BOOST_HAS_THREADS
-    LockFreeMutex             _lock ;
-#endif
+    _Gate                     _lock ;
     _EventMap                 _events ;
     Subject                   _default ;
 
@@ -36,17 +47,13 @@ class EventMap
     Subject                  &get_default() { return _default ; }
     Subject                  *find( const T &evt_id ) 
                               {
-#ifdef BOOST_HAS_THREADS
-                                lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
+                                lock_guard<_Gate>  sc( _lock ) ;
                                 _EventMap_iter  it = _events.find( evt_id ) ;
                                 return (it == _events.end()) ? nullptr : &(*it).second ;
                               }
     Subject                  &get( const T &evt_id ) 
                               {
-#ifdef BOOST_HAS_THREADS
-                                lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
+                                lock_guard<_Gate>  sc( _lock ) ;
                                 _EventMap_iter  it = _events.find( evt_id ) ;
                                 if (it == _events.end())
                                 {
@@ -55,20 +62,27 @@ class EventMap
                                 }
                                 return (*it).second ;
                               }
+    // drops the subject and deletes its observers; false if there was none
+    bool                      erase( const T &evt_id ) 
+                              {
+                                lock_guard<_Gate>  sc( _lock ) ;
+                                return _events.erase( evt_id ) != 0 ;
+                              }
+    size_t                    size() 
+                              {
+                                lock_guard<_Gate>  sc( _lock ) ;
+                                return _events.size() ;
+                              }
     void                      invoke( const T &evt_id ) 
                               {
-#ifdef BOOST_HAS_THREADS
-                                lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
+                                lock_guard<_Gate>  sc( _lock ) ;
                                 Subject *s = find( evt_id ) ;
                                 if (s)  s->invoke({evt_id}) ;
                                 else _default.invoke({evt_id}) ;
                               }
     void                      invoke( const T &evt_id, const std::vector<boost::any> &args_ ) 
                               {
-#ifdef BOOST_HAS_THREADS
-                                lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
+                                lock_guard<_Gate>  sc( _lock ) ;
                                 Subject *s = find( evt_id ) ;
 
                                 std::vector<boost::any> args = {evt_id} ;
@@ -80,6 +94,40 @@ class EventMap
                                 if (s)  s->invoke( args ) ;
                                 else _default.invoke( args ) ;
                               }
+
+    // dispatches n events under one lock.  events are grouped by id with a
+    // stable sort, so each id's events keep their order but events of
+    // different ids may not; each group costs one lookup, and one argument
+    // buffer serves the whole batch.  handlers must not erase() ids.
+    // returns how many events found a subject other than the default
+    size_t                    invoke_batch( const Event *evts, size_t n ) 
+                              {
+                                lock_guard<_Gate>  sc( _lock ) ;
+                                std::vector<size_t>  order( n ) ;
+                                std::iota( order.begin(), order.end(), (size_t)0 ) ;
+                                std::stable_sort( order.begin(), order.end(), [evts]( size_t a, size_t b ){ return evts[a].id < evts[b].id ; } ) ;
+
+                                std::vector<boost::any>  args ;
+                                size_t  hit = 0 ;
+                                for (size_t i = 0, j; i < n; i = j)
+                                {
+                                  const T         &id = evts[ order[i] ].id ;
+                                  _EventMap_iter   it = _events.find( id ) ;
+                                  Subject         &s  = (it == _events.end()) ? _default : (*it).second ;
+                                  for (j = i; (j < n) && !(id < evts[ order[j] ].id); j++)
+                                  {
+                                    const Event  &e = evts[ order[j] ] ;
+                                    args.clear() ;
+                                    args.push_back( e.id ) ;
+                                    args.insert( args.end(), e.args.begin(), e.args.end() ) ;
+                                    s.invoke( args ) ;
+                                  }
+                                  if (it != _events.end())
+                                    hit += j - i ;
+                                }
+                                return hit ;
+                              }
+    size_t                    invoke_batch( const std::vector<Event> &evts ) { return invoke_batch( evts.data(), evts.size() ) ; }
 } ; // class EventMap
 
 }} ; // namespace
@@ -0,0 +1,87 @@
+/*!
+  @file       gate.hpp
+  @brief      gate (threading policy) definitions
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  The _Gate template parameter of basic_subject, Numeric, EventMap, oMap and
+  oVector picks how each object is protected:
+
+    LockFreeMutex      the default; recursive spin lock, safe to share
+    NullMutex          single-threaded: no lock and no atomics, for objects
+                       only ever touched by one thread (per-worker state)
+    any other type     with lock() / unlock(), e.g. std::recursive_mutex.  it
+                       must be recursive: a Numeric holds its gate while its
+                       Subject dispatches, and handlers may re-enter
+
+  gate_traits< _Gate > tells the implementation whether the gate is threaded
+  and which atomic type to use for state read outside the lock.
+*/
+#pragma once
+
+#include <atomic>
+#include "boost/observe/lfmutex.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class NullMutex
+
+  <b>Description:</b>
+  gate for objects confined to one thread.  every operation is a no-op, so a
+  lock_guard< NullMutex > compiles away.
+*/
+class NullMutex
+{
+  public  :
+    void                 lock() {}
+    bool                 try_lock() { return true ; }
+    void                 unlock() {}
+    uint32_t             owner() const { return 0 ; }
+} ; // class NullMutex
+
+/*!
+  @class plain_atomic< T >
+
+  <b>Description:</b>
+  the std::atomic interface the library uses (load / store / fetch_add /
+  exchange), over a plain T.  for single-threaded gates.
+*/
+template <class T>
+class plain_atomic
+{
+  private :
+    T                    _v ;
+
+  public  :
+                         plain_atomic() : _v() {}
+                         plain_atomic( T v ) : _v( v ) {}
+
+    T                    load( std::memory_order = std::memory_order_seq_cst ) const { return _v ; }
+    void                 store( T v, std::memory_order = std::memory_order_seq_cst ) { _v = v ; }
+    T                    exchange( T v, std::memory_order = std::memory_order_seq_cst ) { T  o = _v ; _v = v ; return o ; }
+    T                    fetch_add( T d, std::memory_order = std::memory_order_seq_cst ) { T  o = _v ; _v += d ; return o ; }
+                         operator T() const { return _v ; }
+    plain_atomic        &operator=( T v ) { _v = v ; return *this ; }
+} ; // class plain_atomic
+
+template <class _Gate>
+struct gate_traits
+{
+  enum { threaded = 1 } ;
+  template <class T> using atomic = std::atomic<T> ;
+} ; // struct gate_traits
+
+template <>
+struct gate_traits<NullMutex>
+{
+  enum { threaded = 0 } ;
+  template <class T> using atomic = plain_atomic<T> ;
+} ; // struct gate_traits<NullMutex>
+
+}} ; // namespace
@@ -0,0 +1,250 @@
+/*!
+  @file       graph.hpp
+  @brief      ObserverGraph class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Snapshot of who-observes-whom, taken from the SubjectRegistry.  Requires
+  BOOST_OBSERVERS_REGISTRY; per-edge fire counts and times are filled in when
+  BOOST_OBSERVERS_INSTRUMENT is defined as well, otherwise they read 0.
+*/
+#pragma once
+
+#ifndef BOOST_OBSERVERS_REGISTRY
+#  error "graph.hpp requires BOOST_OBSERVERS_REGISTRY"
+#endif
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "boost/observe/subject.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class ObserverGraph
+
+  <b>Description:</b>
+  three kinds of node and three kinds of edge:
+    subject  --notifies-->  observer   (fire count / cumulative time)
+    observer --calls----->  target     (MemberFunc/MemberPoke object)
+    target   --owns------>  subject    (subjects embedded in that object)
+  the last one is what links  Stock::price -> PositionEntry -> PositionEntry::value.
+
+  <b>Notes:</b>
+  capture() takes each subject's lock with try_lock so that it cannot deadlock
+  against a dispatch in progress; subjects that stay busy are marked as such
+  and reported without their observers.
+*/
+class ObserverGraph
+{
+  public    :
+    enum EdgeKind { EDGE_NOTIFIES, EDGE_CALLS, EDGE_OWNS } ;
+
+    struct SubjectNode
+    {
+      const Subject                    *subj ;
+      const void                       *src ;
+      size_t                            n_watchers ;
+      uint64_t                          invokes ;
+      bool                              busy ;
+    } ;
+    struct ObserverNode
+    {
+      const boost::observers::Observer *obs ;
+      const char                       *kind ;
+      bool                              enabled ;
+    } ;
+    struct TargetNode
+    {
+      const void                       *obj ;
+      size_t                            size ;
+    } ;
+    struct Edge
+    {
+      const void                       *from ;
+      const void                       *to ;
+      EdgeKind                          kind ;
+      uint64_t                          fires ;
+      uint64_t                          ticks ;
+    } ;
+
+  private   :
+    std::vector<SubjectNode>            _subjects ;
+    std::vector<ObserverNode>           _observers ;
+    std::vector<TargetNode>             _targets ;
+    std::vector<Edge>                   _edges ;
+
+    static const char                  *_edge_name( EdgeKind k )
+                                        {
+                                          switch (k)
+                                          {
+                                            case EDGE_NOTIFIES : return "notifies" ;
+                                            case EDGE_CALLS    : return "calls" ;
+                                            default            : return "owns" ;
+                                          }
+                                        }
+    static double                       _nsec( uint64_t ticks )
+                                        {
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                          return Instrument::to_nsec( ticks ) ;
+#else
+                                          return (double)ticks ;
+#endif
+                                        }
+
+  public    :
+                                        ObserverGraph() {}
+
+    void                                clear()
+                                        {
+                                          _subjects.clear() ;
+                                          _observers.clear() ;
+                                          _targets.clear() ;
+                                          _edges.clear() ;
+                                        }
+    void                                capture( uint32_t max_spins = 1000 )
+                                        {
+                                          std::map<const void*, size_t>  targets ;
+
+                                          clear() ;
+                                          SubjectRegistry::instance().for_each( [&]( Subject *s ) {
+                                            SubjectNode  n = { s, s->src(), 0, 0, true } ;
+
+                                            for (uint32_t i = 0; (i < max_spins) && n.busy; i++)
+                                            {
+                                              if (s->lock().try_lock())
+                                                n.busy = false ;
+                                              else
+                                                std::this_thread::yield() ;
+                                            }
+                                            if (!n.busy)
+                                            {
+                                              boost::observers::ObserverVec  v = s->watchers() ;
+                                              n.n_watchers = v.size() ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                              if (s->stats())
+                                                n.invokes = s->stats()->invokes ;
+#endif
+                                              for (boost::observers::Observer *o : v)
+                                              {
+                                                Edge  e = { s, o, EDGE_NOTIFIES, 0, 0 } ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                                e.fires = o->nInvokes() ;
+                                                e.ticks = o->ticks() ;
+#endif
+                                                _observers.push_back( ObserverNode{ o, o->kind(), o->enabled() } ) ;
+                                                _edges.push_back( e ) ;
+                                                if (o->target() != nullptr)
+                                                {
+                                                  _edges.push_back( Edge{ o, o->target(), EDGE_CALLS, 0, 0 } ) ;
+                                                  targets[ o->target() ] = std::max( targets[ o->target() ], o->target_size() ) ;
+                                                }
+                                              }
+                                              s->lock().unlock() ;
+                                            }
+                                            _subjects.push_back( n ) ;
+                                          }) ;
+
+                                          // target -> subjects that live inside it
+                                          std::sort( _subjects.begin(), _subjects.end(),
+                                                     []( const SubjectNode &a, const SubjectNode &b ){ return a.subj < b.subj ; } ) ;
+                                          for (auto &t : targets)
+                                          {
+                                            const char  *lo = (const char *)t.first ;
+                                            const char  *hi = lo + t.second ;
+                                            _targets.push_back( TargetNode{ t.first, t.second } ) ;
+
+                                            auto it = std::lower_bound( _subjects.begin(), _subjects.end(), (const Subject *)lo,
+                                                                        []( const SubjectNode &a, const Subject *p ){ return a.subj < p ; } ) ;
+                                            for ( ; (it != _subjects.end()) && ((const char *)(*it).subj < hi); it++)
+                                              _edges.push_back( Edge{ t.first, (*it).subj, EDGE_OWNS, 0, 0 } ) ;
+                                          }
+                                        }
+
+    // the n subjects with the most direct observers, largest first
+    std::vector<SubjectNode>            top_fanout( size_t n ) const
+                                        {
+                                          std::vector<SubjectNode>  v( _subjects ) ;
+                                          std::sort( v.begin(), v.end(),
+                                                     []( const SubjectNode &a, const SubjectNode &b ){ return a.n_watchers > b.n_watchers ; } ) ;
+                                          if (v.size() > n)  v.resize( n ) ;
+                                          return v ;
+                                        }
+
+    void                                write_dot( std::ostream &os ) const
+                                        {
+                                          os << "digraph observers {\n" ;
+                                          for (auto &n : _subjects)
+                                            os << "  \"" << (const void *)n.subj << "\" [shape=box,label=\"Subject " << (const void *)n.subj
+                                               << "\\nwatchers=" << n.n_watchers << " invokes=" << n.invokes << (n.busy ? "\\n(busy)" : "") << "\"];\n" ;
+                                          for (auto &n : _observers)
+                                            os << "  \"" << (const void *)n.obs << "\" [shape=ellipse,label=\"" << n.kind << "\""
+                                               << (n.enabled ? "" : ",style=dotted") << "];\n" ;
+                                          for (auto &n : _targets)
+                                            os << "  \"" << n.obj << "\" [shape=component,label=\"object " << n.obj << "\\n" << n.size << " bytes\"];\n" ;
+                                          for (auto &e : _edges)
+                                          {
+                                            os << "  \"" << e.from << "\" -> \"" << e.to << "\"" ;
+                                            if (e.kind == EDGE_NOTIFIES)
+                                              os << " [label=\"fires=" << e.fires << " ns=" << (uint64_t)_nsec( e.ticks ) << "\"]" ;
+                                            else if (e.kind == EDGE_OWNS)
+                                              os << " [style=dashed]" ;
+                                            os << ";\n" ;
+                                          }
+                                          os << "}\n" ;
+                                        }
+    void                                write_json( std::ostream &os ) const
+                                        {
+                                          const char  *sep = "" ;
+
+                                          os << "{\n  \"subjects\": [" ;
+                                          for (auto &n : _subjects)
+                                          {
+                                            os << sep << "\n    { \"id\": \"" << (const void *)n.subj << "\", \"src\": \"" << n.src
+                                               << "\", \"watchers\": " << n.n_watchers << ", \"invokes\": " << n.invokes
+                                               << ", \"busy\": " << (n.busy ? "true" : "false") << " }" ;
+                                            sep = "," ;
+                                          }
+                                          os << "\n  ],\n  \"observers\": [" ;
+                                          sep = "" ;
+                                          for (auto &n : _observers)
+                                          {
+                                            os << sep << "\n    { \"id\": \"" << (const void *)n.obs << "\", \"kind\": \"" << n.kind
+                                               << "\", \"enabled\": " << (n.enabled ? "true" : "false") << " }" ;
+                                            sep = "," ;
+                                          }
+                                          os << "\n  ],\n  \"targets\": [" ;
+                                          sep = "" ;
+                                          for (auto &n : _targets)
+                                          {
+                                            os << sep << "\n    { \"id\": \"" << n.obj << "\", \"size\": " << n.size << " }" ;
+                                            sep = "," ;
+                                          }
+                                          os << "\n  ],\n  \"edges\": [" ;
+                                          sep = "" ;
+                                          for (auto &e : _edges)
+                                          {
+                                            os << sep << "\n    { \"from\": \"" << e.from << "\", \"to\": \"" << e.to << "\", \"kind\": \"" << _edge_name( e.kind )
+                                               << "\", \"fires\": " << e.fires << ", \"ns\": " << (uint64_t)_nsec( e.ticks ) << " }" ;
+                                            sep = "," ;
+                                          }
+                                          os << "\n  ]\n}\n" ;
+                                        }
+
+    // access methods
+    const std::vector<SubjectNode>     &subjects() const { return _subjects ; }
+    const std::vector<ObserverNode>    &observers() const { return _observers ; }
+    const std::vector<TargetNode>      &targets() const { return _targets ; }
+    const std::vector<Edge>            &edges() const { return _edges ; }
+} ; // class ObserverGraph
+
+}} ; // namespace
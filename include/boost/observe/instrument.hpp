@@ -0,0 +1,181 @@
+/*!
+  @file       instrument.hpp
+  @brief      optional hot-path instrumentation for Subject, Observer and LockFreeMutex
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Everything here is compiled in only when BOOST_OBSERVERS_INSTRUMENT is defined.
+  Timing uses the TSC where available.  Counters are plain integers: a Subject
+  and its Observers are only ever touched while the Subject's lock is held, so
+  each one is accumulated by one thread at a time without atomics.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <boost/predef.h>
+
+#if BOOST_COMP_MSVC
+#  include <intrin.h>
+#elif BOOST_ARCH_X86
+#  include <x86intrin.h>
+#endif
+
+namespace boost { namespace observers { class Observer ; }} ;
+
+namespace boost { namespace observables {
+
+class LockFreeMutex ;
+template <class _Gate> class basic_subject ;
+typedef basic_subject<LockFreeMutex>   Subject ;
+
+inline uint64_t tsc()
+{
+#if BOOST_ARCH_X86
+  return __rdtsc() ;
+#else
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch() ).count() ;
+#endif
+} // :: tsc
+
+/*!
+  @class LatencyHistogram
+
+  <b>Description:</b>
+  HDR-style histogram of tick counts.  values below 2^SUB_BITS get a bucket each;
+  above that every power of two is split into 2^SUB_BITS linear sub-buckets, so
+  the relative error of any reported percentile is bounded by 1/2^SUB_BITS.
+  values beyond 2^MAX_MAG are clamped into the last bucket.
+*/
+class LatencyHistogram
+{
+  public    :
+    enum { SUB_BITS = 3, SUB = (1 << SUB_BITS), MAX_MAG = 40, N_BUCKETS = (MAX_MAG - SUB_BITS + 2) * SUB } ;
+
+  private   :
+    uint32_t             _counts[ N_BUCKETS ] ;
+    uint64_t             _n ;
+    uint64_t             _sum ;
+    uint64_t             _max ;
+
+    static int           _msb( uint64_t v )
+                         {
+                           int  m = 0 ;
+                           while (v >>= 1)  m++ ;
+                           return m ;
+                         }
+    static uint32_t      _bucket( uint64_t v )
+                         {
+                           if (v < SUB)  return (uint32_t)v ;
+                           int  mag = _msb( v ) ;
+                           if (mag > MAX_MAG)  return N_BUCKETS - 1 ;
+                           return (uint32_t)((mag - SUB_BITS + 1) * SUB + ((v >> (mag - SUB_BITS)) & (SUB - 1))) ;
+                         }
+    static uint64_t      _lowest( uint32_t b )
+                         {
+                           if (b < SUB)  return b ;
+                           int  mag = (int)(b / SUB) + SUB_BITS - 1 ;
+                           return ((uint64_t)(SUB + (b % SUB))) << (mag - SUB_BITS) ;
+                         }
+
+  public    :
+                         LatencyHistogram() { reset() ; }
+
+    void                 reset()
+                         {
+                           memset( _counts, 0, sizeof(_counts) ) ;
+                           _n = _sum = _max = 0 ;
+                         }
+    void                 record( uint64_t ticks )
+                         {
+                           _counts[ _bucket( ticks ) ]++ ;
+                           _n++ ;
+                           _sum += ticks ;
+                           if (ticks > _max)  _max = ticks ;
+                         }
+
+    // access methods
+    uint64_t             count() const { return _n ; }
+    uint64_t             total() const { return _sum ; }
+    uint64_t             max() const { return _max ; }
+    double               mean() const { return (_n == 0) ? 0.0 : (double)_sum / (double)_n ; }
+    uint64_t             percentile( double p ) const   // p in [0,100]; lower edge of the bucket
+                         {
+                           if (_n == 0)  return 0 ;
+                           uint64_t  want = (uint64_t)((p / 100.0) * (double)_n + 0.5) ;
+                           uint64_t  seen = 0 ;
+                           if (want == 0)  want = 1 ;
+                           for (uint32_t b = 0; b < N_BUCKETS; b++)
+                           {
+                             seen += _counts[b] ;
+                             if (seen >= want)
+                               return _lowest( b ) ;
+                           }
+                           return _max ;
+                         }
+} ; // class LatencyHistogram
+
+// per-Subject counters; allocated on the first instrumented invoke
+struct SubjectStats
+{
+  uint64_t               invokes ;
+  LatencyHistogram       latency ;   // ticks for a whole invoke, all observers
+
+                         SubjectStats() : invokes( 0 ) {}
+} ; // struct SubjectStats
+
+typedef std::function<void( Subject *, boost::observers::Observer *, uint64_t )>   SlowObserverFunc ;
+
+/*!
+  @class Instrument
+
+  <b>Description:</b>
+  process-wide settings: the slow-observer budget/callback and the tick clock
+  calibration.  the callback runs on the dispatching thread with the Subject
+  still locked, so it should only record, not re-enter the graph.
+*/
+class Instrument
+{
+  private   :
+    static uint64_t     &_budget() { static uint64_t b = 0 ; return b ; }
+    static SlowObserverFunc &_on_slow() { static SlowObserverFunc f ; return f ; }
+
+  public    :
+    // ticks per nanosecond, measured once against the steady clock
+    static double        ticks_per_nsec()
+                         {
+                           static double  r = [](){
+                             auto      c0 = std::chrono::steady_clock::now() ;
+                             uint64_t  t0 = tsc() ;
+                             while (std::chrono::steady_clock::now() - c0 < std::chrono::milliseconds( 10 )) ;
+                             uint64_t  t1 = tsc() ;
+                             auto      ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - c0 ).count() ;
+                             return (ns > 0) ? (double)(t1 - t0) / (double)ns : 1.0 ;
+                           }() ;
+                           return r ;
+                         }
+    static double        to_nsec( uint64_t ticks ) { return (double)ticks / ticks_per_nsec() ; }
+
+    // budget_ns == 0 disables slow-observer reporting
+    static void          set_slow_observer( uint64_t budget_ns, SlowObserverFunc f )
+                         {
+                           _budget()  = (uint64_t)((double)budget_ns * ticks_per_nsec()) ;
+                           _on_slow() = f ;
+                         }
+    static inline void   observed( Subject *s, boost::observers::Observer *o, uint64_t ticks )
+                         {
+                           uint64_t  b = _budget() ;
+                           if ((b != 0) && (ticks > b) && _on_slow())
+                             _on_slow()( s, o, ticks ) ;
+                         }
+} ; // class Instrument
+
+}} ; // namespace
@@ -0,0 +1,512 @@
+/*!
+  @file       journal.hpp
+  @brief      Journal / JournalReplayer class definitions
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Append-only binary recording of notifications and high-speed replay.
+
+  file layout (little endian, 8-byte aligned):
+    JournalHeader
+    { JournalRecord  payload[len]  pad-to-8 } ...
+
+  Writers fill a per-thread buffer with no locking and copy it into the mapped
+  file when full, reserving space with one compare-exchange.  Records are
+  therefore in file order per thread; across threads they interleave in
+  buffer-sized chunks, each record carrying its own timestamp.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "boost/observe/numerics.hpp"
+#include "boost/observe/ovector.hpp"
+#include "boost/observe/omap.hpp"
+
+namespace boost { namespace observables {
+
+enum JournalOp { JOP_VALUE = 1, JOP_INSERT, JOP_ERASE, JOP_ARGS } ;
+
+struct JournalHeader
+{
+  uint32_t                 magic ;         // 'OBSJ'
+  uint32_t                 version ;
+  uint64_t                 capacity ;      // bytes, including this header
+  std::atomic<uint64_t>    used ;          // bytes written, including this header
+  uint64_t                 reserved ;
+} ; // struct JournalHeader
+
+struct JournalRecord
+{
+  uint32_t                 subject ;       // id given when the tap was attached
+  uint8_t                  op ;            // JournalOp
+  uint8_t                  pad ;
+  uint16_t                 len ;           // payload bytes
+  uint64_t                 ts ;            // steady clock, ns
+} ; // struct JournalRecord
+
+enum { JOURNAL_MAGIC = 0x4a53424f, JOURNAL_VERSION = 1 } ;
+
+inline uint64_t journal_now()
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch() ).count() ;
+} // :: journal_now
+
+/*!
+  @class Journal
+
+  <b>Description:</b>
+  recorder.  attach taps to the subjects to capture, then let the graph run.
+  payload types must be trivially copyable; oVector/oMap taps record the
+  element (and index / key) rather than the iterator.
+
+  <b>Notes:</b>
+  flush() pushes the calling thread's buffer; close() (and the destructor)
+  pushes every thread's buffer and must only run once writers have stopped.
+  when the file is full further records are counted in dropped() and lost.
+  a record too large for a thread buffer goes straight to the file.  taps
+  share a link with the journal that close() cuts; each then expires on its
+  subject's next change, so subjects may outlive the journal.  close() may
+  run inside a tap's dispatch: it waits out only the other threads' taps.
+  the destructor must not.
+*/
+class Journal
+{
+  private   :
+    enum { BUFFER_SIZE = 64 * 1024 } ;
+
+    struct _Buffer
+    {
+      char                 data[ BUFFER_SIZE ] ;
+      size_t               used ;
+                           _Buffer() : used( 0 ) {}
+    } ;
+
+    // shared with the taps, so they can outlive us.  close() clears journal
+    // and waits out the taps recording through it; taps recording at once
+    // do not wait for each other
+    struct _Link
+    {
+      std::atomic<Journal *>         journal ;
+      std::atomic<uint32_t>          active ;
+    } ;
+
+    // the link this thread is recording through, if any
+    static _Link                        *&_inside()
+                                          {
+                                            static thread_local _Link  *link = nullptr ;
+                                            return link ;
+                                          }
+
+    class _Tap : public boost::observers::Observer
+    {
+      public    :
+        typedef std::function<void( Journal &, const std::vector<boost::any> & )>  Fn ;
+
+      protected :
+        std::shared_ptr<_Link>       _link ;
+        Fn                           _fn ;
+
+      public    :
+                                     _Tap( const std::shared_ptr<_Link> &l, const Fn &f ) : _link( l ), _fn( f ) {}
+
+        virtual int                  invoke() { return 0 ; }
+        virtual int                  invoke( const std::vector<boost::any> &args )
+                                     {
+                                       _link->active++ ;
+                                       Journal  *j = _link->journal.load() ;
+                                       if (j == nullptr)
+                                         expire() ;
+                                       else
+                                       {
+                                         _Link  *outer = _inside() ;
+                                         _inside() = _link.get() ;
+                                         try { _fn( *j, args ) ; }
+                                         catch (...) { _inside() = outer ; _link->active-- ; throw ; }
+                                         _inside() = outer ;
+                                       }
+                                       _link->active-- ;
+                                       return 0 ;
+                                     }
+        virtual const char          *kind() const { return "Journal" ; }
+    } ; // class _Tap
+
+    // this thread's buffer per journal id; ids are never reused
+    struct _Locals
+    {
+      uint64_t                       owner ;
+      _Buffer                       *buf ;
+      std::unordered_map<uint64_t, _Buffer *>  all ;
+                                     _Locals() : owner( 0 ), buf( nullptr ) {}
+    } ;
+
+    boost::interprocess::file_mapping     _file ;
+    boost::interprocess::mapped_region    _region ;
+    JournalHeader                        *_hdr ;
+    char                                 *_base ;
+    uint64_t                              _id ;
+    std::atomic<uint64_t>                 _dropped ;
+#ifdef BOOST_HAS_THREADS
+    LockFreeMutex                         _lock ;      // guards _buffers (registration only)
+#endif
+    std::vector< std::unique_ptr<_Buffer> >  _buffers ;
+    std::shared_ptr<_Link>                _link ;
+
+    static uint64_t                       _next_id() { static std::atomic<uint64_t> n( 1 ) ; return n++ ; }
+    static size_t                         _pad8( size_t n ) { return (n + 7) & ~(size_t)7 ; }
+
+    _Buffer                              &_local()
+                                          {
+                                            static thread_local _Locals  loc ;
+                                            if (loc.owner != _id)
+                                            {
+                                              _Buffer  *&buf = loc.all[ _id ] ;
+                                              if (buf == nullptr)
+                                              {
+#ifdef BOOST_HAS_THREADS
+                                                lock_guard<LockFreeMutex>  sc( _lock ) ;
+#endif
+                                                _buffers.emplace_back( new _Buffer() ) ;
+                                                buf = _buffers.back().get() ;
+                                              }
+                                              loc.buf   = buf ;
+                                              loc.owner = _id ;
+                                            }
+                                            return *loc.buf ;
+                                          }
+    // n bytes of the file, or nullptr (counted as dropped) once full or closed
+    char                                 *_claim( size_t n )
+                                          {
+                                            if (_base == nullptr)
+                                            {
+                                              _dropped += n ;
+                                              return nullptr ;
+                                            }
+                                            uint64_t  off = _hdr->used.load() ;
+                                            do
+                                            {
+                                              if (off + n > _hdr->capacity)
+                                              {
+                                                _dropped += n ;
+                                                return nullptr ;
+                                              }
+                                            } while (!_hdr->used.compare_exchange_weak( off, off + n )) ;
+                                            return _base + off ;
+                                          }
+    void                                  _spill( _Buffer &b )
+                                          {
+                                            if (b.used == 0)  return ;
+                                            if (char *p = _claim( b.used ))
+                                              memcpy( p, b.data, b.used ) ;
+                                            b.used = 0 ;
+                                          }
+    static void                           _fill( char *at, uint32_t subject, uint8_t op, const void *p, uint16_t len )
+                                          {
+                                            JournalRecord  *r = (JournalRecord *)at ;
+                                            r->subject = subject ;
+                                            r->op      = op ;
+                                            r->pad     = 0 ;
+                                            r->len     = len ;
+                                            r->ts      = journal_now() ;
+                                            memcpy( r + 1, p, len ) ;
+                                          }
+    template <class G>
+    boost::observers::Observer           *_tap( basic_subject<G> &s, const typename _Tap::Fn &f )
+                                          {
+                                            return s.install( new _Tap( _link, f )) ;
+                                          }
+
+    template <class... Args>
+    static constexpr size_t               _args_size() { return (0 + ... + sizeof(Args)) ; }
+    template <class A>
+    static void                           _put( char *buf, size_t &off, const boost::any &a )
+                                          {
+                                            static_assert( std::is_trivially_copyable<A>::value, "journal payloads must be trivially copyable" ) ;
+                                            A  v = boost::any_cast<A>( a ) ;
+                                            memcpy( buf + off, &v, sizeof(A) ) ;
+                                            off += sizeof(A) ;
+                                          }
+
+  public    :
+                                          Journal( const char *path, uint64_t capacity )
+                                          : _hdr( nullptr ), _base( nullptr ), _id( _next_id() ), _dropped( 0 ), _link( std::make_shared<_Link>() )
+                                          {
+                                            _link->journal = this ;
+                                            _link->active  = 0 ;
+                                            if (capacity < sizeof(JournalHeader) + BUFFER_SIZE)
+                                              capacity = sizeof(JournalHeader) + BUFFER_SIZE ;
+                                            {
+                                              std::filebuf  fb ;
+                                              fb.open( path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary ) ;
+                                              fb.pubseekoff( capacity - 1, std::ios_base::beg ) ;
+                                              fb.sputc( 0 ) ;
+                                            }
+                                            _file   = boost::interprocess::file_mapping( path, boost::interprocess::read_write ) ;
+                                            _region = boost::interprocess::mapped_region( _file, boost::interprocess::read_write ) ;
+                                            _region.advise( boost::interprocess::mapped_region::advice_sequential ) ;
+                                            _base   = (char *)_region.get_address() ;
+                                            _hdr    = new (_base) JournalHeader ;
+                                            _hdr->magic    = JOURNAL_MAGIC ;
+                                            _hdr->version  = JOURNAL_VERSION ;
+                                            _hdr->capacity = capacity ;
+                                            _hdr->used     = sizeof(JournalHeader) ;
+                                          }
+                                         ~Journal() { close() ; }
+
+    void                                  record( uint32_t subject, uint8_t op, const void *p, uint16_t len )
+                                          {
+                                            _Buffer  &b = _local() ;
+                                            size_t    n = sizeof(JournalRecord) + _pad8( len ) ;
+                                            if (b.used + n > BUFFER_SIZE)
+                                              _spill( b ) ;
+                                            if (n > BUFFER_SIZE)
+                                            {
+                                              // after the spill, so this thread's records stay in order
+                                              if (char *at = _claim( n ))
+                                                _fill( at, subject, op, p, len ) ;
+                                              return ;
+                                            }
+                                            _fill( b.data + b.used, subject, op, p, len ) ;
+                                            b.used += n ;
+                                          }
+    void                                  flush() { _spill( _local() ) ; }
+    void                                  close()
+                                          {
+                                            if (_base == nullptr)  return ;
+                                            _link->journal = nullptr ;
+                                            // a tap of ours further up this thread's stack is not waited for
+                                            uint32_t  mine = (_inside() == _link.get()) ? 1 : 0 ;
+                                            while (_link->active.load() > mine)
+                                              std::this_thread::yield() ;
+#ifdef BOOST_HAS_THREADS
+                                            lock_guard<LockFreeMutex>  sc( _lock ) ;
+#endif
+                                            for (auto &b : _buffers)
+                                              _spill( *b ) ;
+                                            _region.flush() ;
+                                            _base = nullptr ;
+                                          }
+
+    // taps.  each installs observers that record into this journal under id,
+    // and returns them
+    template <class T, class G>
+    boost::observers::Observer           *tap( Numeric<T, G> &n, uint32_t id )
+                                          {
+                                            static_assert( std::is_trivially_copyable<T>::value, "journal payloads must be trivially copyable" ) ;
+                                            return _tap( n.valueCB(), [id]( Journal &j, const std::vector<boost::any> &args ) {
+                                              T  v = boost::any_cast<T>( args[0] ) ;
+                                              j.record( id, JOP_VALUE, &v, sizeof(T) ) ;
+                                            }) ;
+                                          }
+    template <class T, class G>
+    boost::observers::ObserverVec         tap( oVector<T, G> &vec, uint32_t id )
+                                          {
+                                            static_assert( std::is_trivially_copyable<T>::value, "journal payloads must be trivially copyable" ) ;
+                                            typedef typename oVector<T, G>::iterator  iter ;
+                                            struct Entry { uint64_t ndx ; T value ; } ;
+                                            auto  rec = [id, &vec]( uint8_t op ) {
+                                              return [id, &vec, op]( Journal &j, const std::vector<boost::any> &args ) {
+                                                iter   it = boost::any_cast<iter>( args[0] ) ;
+                                                Entry  e ;
+                                                memset( &e, 0, sizeof(e) ) ;
+                                                e.ndx   = (uint64_t)(it - vec.begin()) ;
+                                                e.value = *it ;
+                                                j.record( id, op, &e, sizeof(e) ) ;
+                                              } ;
+                                            } ;
+                                            return { _tap( vec.postInsertCB(), rec( JOP_INSERT )),
+                                                     _tap( vec.preEraseCB  (), rec( JOP_ERASE  )) } ;
+                                          }
+    template <class K, class V, class P, class G>
+    boost::observers::ObserverVec         tap( oMap<K, V, P, G> &map, uint32_t id )
+                                          {
+                                            static_assert( std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                                                           "journal payloads must be trivially copyable" ) ;
+                                            typedef typename std::map<K, V, P>::iterator  iter ;
+                                            struct Entry { K key ; V value ; } ;
+                                            auto  rec = [id]( uint8_t op ) {
+                                              return [id, op]( Journal &j, const std::vector<boost::any> &args ) {
+                                                iter   it = boost::any_cast<iter>( args[0] ) ;
+                                                Entry  e ;
+                                                memset( &e, 0, sizeof(e) ) ;
+                                                e.key   = (*it).first ;
+                                                e.value = (*it).second ;
+                                                j.record( id, op, &e, (op == JOP_ERASE) ? sizeof(K) : sizeof(e) ) ;
+                                              } ;
+                                            } ;
+                                            return { _tap( map.postInsertCB(), rec( JOP_INSERT )),
+                                                     _tap( map.preEraseCB  (), rec( JOP_ERASE  )),
+                                                     _tap( map.updateCB    (), rec( JOP_INSERT )) } ;
+                                          }
+    // any subject whose arguments are the listed trivially copyable types;
+    // for an EventMap pass evts.get( evt_id ) and the id type first
+    template <class... Args, class G>
+    boost::observers::Observer           *tap_args( basic_subject<G> &s, uint32_t id )
+                                          {
+                                            static_assert( sizeof...(Args) > 0, "list the argument types" ) ;
+                                            return _tap( s, [id]( Journal &j, const std::vector<boost::any> &args ) {
+                                              char    buf[ _args_size<Args...>() ] ;
+                                              size_t  off = 0, i = 0 ;
+                                              (void)std::initializer_list<int>{ (_put<Args>( buf, off, args[i++] ), 0)... } ;
+                                              j.record( id, JOP_ARGS, buf, (uint16_t)sizeof(buf) ) ;
+                                            }) ;
+                                          }
+
+    // access methods
+    uint64_t                              used() const { return _hdr->used.load() ; }
+    uint64_t                              capacity() const { return _hdr->capacity ; }
+    uint64_t                              dropped() const { return _dropped.load() ; }
+} ; // class Journal
+
+/*!
+  @class JournalReplayer
+
+  <b>Description:</b>
+  maps a journal read-only and drives each record into whatever was bound to
+  its subject id.  records are read in place; nothing is parsed into heap
+  objects, so the cost per record is a table lookup and the sink itself.
+  records with no sink bound are skipped.
+*/
+class JournalReplayer
+{
+  public    :
+    typedef std::function<void( const JournalRecord &, const char * )>   Sink ;
+
+  private   :
+    boost::interprocess::file_mapping     _file ;
+    boost::interprocess::mapped_region    _region ;
+    const JournalHeader                  *_hdr ;
+    const char                           *_base ;
+    uint64_t                              _end ;
+    uint64_t                              _pos ;
+    std::vector<Sink>                     _sinks ;
+
+    template <class A>
+    static A                              _get( const char *p, size_t &off )
+                                          {
+                                            A  v ;
+                                            memcpy( &v, p + off, sizeof(A) ) ;
+                                            off += sizeof(A) ;
+                                            return v ;
+                                          }
+
+  public    :
+                                          JournalReplayer( const char *path )
+                                          : _file( path, boost::interprocess::read_only )
+                                          , _region( _file, boost::interprocess::read_only )
+                                          {
+                                            _region.advise( boost::interprocess::mapped_region::advice_sequential ) ;
+                                            _base = (const char *)_region.get_address() ;
+                                            _hdr  = (const JournalHeader *)_base ;
+                                            if ((_region.get_size() < sizeof(JournalHeader)) || (_hdr->magic != JOURNAL_MAGIC) || (_hdr->version != JOURNAL_VERSION))
+                                              throw BadJournal() ;
+                                            _end  = std::min<uint64_t>( _hdr->used.load(), _region.get_size() ) ;
+                                            _pos  = sizeof(JournalHeader) ;
+                                          }
+
+    void                                  bind( uint32_t id, const Sink &s )
+                                          {
+                                            if (id >= _sinks.size())  _sinks.resize( id + 1 ) ;
+                                            _sinks[ id ] = s ;
+                                          }
+    template <class T, class G>
+    void                                  bind( uint32_t id, Numeric<T, G> &n )
+                                          {
+                                            bind( id, [&n]( const JournalRecord &, const char *p ) {
+                                              T  v ;
+                                              memcpy( &v, p, sizeof(T) ) ;
+                                              n = v ;
+                                            }) ;
+                                          }
+    template <class T, class G>
+    void                                  bind( uint32_t id, oVector<T, G> &vec )
+                                          {
+                                            struct Entry { uint64_t ndx ; T value ; } ;
+                                            bind( id, [&vec]( const JournalRecord &r, const char *p ) {
+                                              Entry  e ;
+                                              memcpy( &e, p, sizeof(e) ) ;
+                                              if (r.op == JOP_INSERT)
+                                              {
+                                                if (e.ndx >= vec.size())
+                                                  vec.push_back( e.value ) ;
+                                                else
+                                                  vec.insert( vec.begin() + e.ndx, 1, e.value ) ;
+                                              }
+                                              else if ((r.op == JOP_ERASE) && (e.ndx < vec.size()))
+                                                vec.erase( vec.begin() + e.ndx ) ;
+                                            }) ;
+                                          }
+    template <class K, class V, class P, class G>
+    void                                  bind( uint32_t id, oMap<K, V, P, G> &map )
+                                          {
+                                            bind( id, [&map]( const JournalRecord &r, const char *p ) {
+                                              K  k ;
+                                              memcpy( &k, p, sizeof(K) ) ;
+                                              if (r.op == JOP_ERASE)
+                                                map.erase( k ) ;
+                                              else
+                                              {
+                                                V  v ;
+                                                memcpy( &v, p + (r.len - sizeof(V)), sizeof(V) ) ;
+                                                map.update( std::make_pair( k, v )) ;
+                                              }
+                                            }) ;
+                                          }
+    template <class... Args, class G>
+    void                                  bind_args( uint32_t id, basic_subject<G> &s )
+                                          {
+                                            bind( id, [&s]( const JournalRecord &, const char *p ) {
+                                              size_t  off = 0 ;
+                                              s.invoke({ boost::any( _get<Args>( p, off ))... }) ;
+                                            }) ;
+                                          }
+
+    // replays up to max records (or until ts_limit); returns how many were read
+    uint64_t                              replay( uint64_t max = UINT64_MAX, uint64_t ts_limit = UINT64_MAX )
+                                          {
+                                            uint64_t  n = 0 ;
+                                            while ((_pos + sizeof(JournalRecord) <= _end) && (n < max))
+                                            {
+                                              const JournalRecord  *r = (const JournalRecord *)(_base + _pos) ;
+                                              if ((r->ts == 0) || (r->ts > ts_limit))
+                                                break ;
+                                              if ((r->subject < _sinks.size()) && _sinks[ r->subject ])
+                                                _sinks[ r->subject ]( *r, (const char *)(r + 1) ) ;
+                                              _pos += sizeof(JournalRecord) + ((r->len + 7) & ~7) ;
+                                              n++ ;
+                                            }
+                                            return n ;
+                                          }
+    void                                  rewind() { _pos = sizeof(JournalHeader) ; }
+
+    // access methods
+    bool                                  done() const { return (_pos + sizeof(JournalRecord) > _end) ; }
+    uint64_t                              size() const { return _end ; }
+
+    // exception objects
+    class BadJournal
+    {
+      public :
+         BadJournal() {}
+    } ; // JournalReplayer Exception class
+} ; // class JournalReplayer
+
+}} ; // namespace
@@ -15,6 +15,19 @@
 #include <atomic>
 #include <boost/predef.h>
 
+// the instrumented build always carries the lock statistics
+#if defined(BOOST_OBSERVERS_INSTRUMENT) && !defined(BOOST_OBSERVERS_LOCK_STATS)
+#  define  BOOST_OBSERVERS_LOCK_STATS
+#endif
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+#  include <string.h>
+#  include <map>
+#  include <mutex>
+#  include <string>
+#  include <vector>
+#  include "boost/observe/instrument.hpp"
+#endif
+
 #if BOOST_OS_WINDOWS
 #  include <windows.h>
 #  define  get_thread_id     GetCurrentThreadId
@@ -27,20 +40,122 @@ namespace boost { namespace observables {
 
 typedef std::atomic<uint32_t>   hAtomic ;
 
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+/*!
+  @class LockStats
+
+  <b>Description:</b>
+  contention figures for one gate, or the sum over all gates sharing a name.
+  acquisitions/contended/spins count every outermost acquire; the tick figures
+  only cover the sampled ones (see LockFreeMutex::set_sample_rate).
+*/
+struct LockStats
+{
+  uint64_t               acquisitions ;    // outermost acquires
+  uint64_t               contended ;       // acquires that had to spin
+  uint64_t               spins ;           // failed compare-exchange attempts
+  uint64_t               samples ;         // acquires that were timed
+  uint64_t               wait_ticks ;      // sampled time spent spinning
+  uint64_t               max_hold_ticks ;  // longest sampled hold
+
+                         LockStats() { memset( this, 0, sizeof(*this) ) ; }
+
+  void                   merge( const LockStats &o )
+                         {
+                           acquisitions += o.acquisitions ;
+                           contended    += o.contended ;
+                           spins        += o.spins ;
+                           samples      += o.samples ;
+                           wait_ticks   += o.wait_ticks ;
+                           if (o.max_hold_ticks > max_hold_ticks)
+                             max_hold_ticks = o.max_hold_ticks ;
+                         }
+} ; // struct LockStats
+
+class LockFreeMutex ;
+
+// named gates, so figures can be summed per role (every "oMap::_gate" etc).
+// guarded by a std::mutex rather than a LockFreeMutex so it never measures itself
+class LockStatsRegistry
+{
+  private :
+    std::mutex                                        _mtx ;
+    std::multimap<std::string, const LockFreeMutex*>  _live ;
+    std::map<std::string, LockStats>                  _retired ;
+
+  public  :
+    static LockStatsRegistry   &instance() { static LockStatsRegistry r ; return r ; }
+
+    void                        add( const std::string &name, const LockFreeMutex *m ) ;
+    void                        remove( const std::string &name, const LockFreeMutex *m ) ;
+    std::map<std::string, LockStats>  by_name() ;
+} ; // class LockStatsRegistry
+#endif
+
 class LockFreeMutex
 {
   private :
     hAtomic              _lock ;
     uint16_t             _cnt ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+    // written only by the owner; atomics so that readers on other threads are
+    // race-free.  relaxed load/store pairs, never read-modify-write
+    std::atomic<uint64_t>  _acquisitions ;
+    std::atomic<uint64_t>  _contended ;
+    std::atomic<uint64_t>  _spins ;
+    std::atomic<uint64_t>  _samples ;
+    std::atomic<uint64_t>  _wait_ticks ;
+    std::atomic<uint64_t>  _max_hold ;
+    uint64_t               _acquired_at ;  // tsc of a sampled acquire, else 0
+    const char            *_name ;
+
+    static std::atomic<uint32_t> &_sample_rate() { static std::atomic<uint32_t> r( 1 ) ; return r ; }
+    static void          _add( std::atomic<uint64_t> &c, uint64_t n ) 
+                         { c.store( c.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed ) ; }
+    bool                 _sampling() const
+                         {
+                           uint32_t  r = _sample_rate().load( std::memory_order_relaxed ) ;
+                           return (r != 0) && ((_acquisitions.load( std::memory_order_relaxed ) % r) == 0) ;
+                         }
+    void                 _acquired( uint64_t spins, uint64_t t0, bool sample )
+                         {
+                           _add( _acquisitions, 1 ) ;
+                           if (spins != 0)
+                           {
+                             _add( _contended, 1 ) ;
+                             _add( _spins, spins ) ;
+                           }
+                           _acquired_at = sample ? tsc() : 0 ;
+                           if (sample && (t0 != 0))
+                             _add( _wait_ticks, _acquired_at - t0 ) ;
+                         }
+    void                 _releasing()
+                         {
+                           if (_acquired_at == 0)  return ;
+                           uint64_t  held = tsc() - _acquired_at ;
+                           _add( _samples, 1 ) ;
+                           if (held > _max_hold.load( std::memory_order_relaxed ))
+                             _max_hold.store( held, std::memory_order_relaxed ) ;
+                           _acquired_at = 0 ;
+                         }
+#endif
 
   public  :
                          LockFreeMutex() 
                          {
                            _lock = 0 ;
                            _cnt  = 0 ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           _acquisitions = _contended = _spins = _samples = _wait_ticks = _max_hold = 0 ;
+                           _acquired_at  = 0 ;
+                           _name         = nullptr ;
+#endif
                          }
                         ~LockFreeMutex() 
                          {
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           if (_name)  LockStatsRegistry::instance().remove( _name, this ) ;
+#endif
                            _lock = 0 ;
                            _cnt  = 0 ;
                          }
@@ -50,21 +165,51 @@ class LockFreeMutex
 #ifdef BOOST_HAS_THREADS
                            uint32_t  tid  = get_thread_id() ; 
                            uint32_t  zero = 0 ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           bool      sample = _sampling() ;
+                           uint64_t  spins  = 0 ;
+                           uint64_t  t0     = 0 ;
+#endif
 
                            // lock-free mutex
                            while (std::atomic_compare_exchange_strong( &_lock, &zero, tid ) == false)
                            {
                              if (zero == tid)
                                break ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                             if ((spins++ == 0) && sample)  t0 = tsc() ;
+#endif
                              zero = 0 ;
                            }
                            _cnt++ ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           if (_cnt == 1)  _acquired( spins, t0, sample ) ;  // owned now; no race
+#endif
+#endif
+                         }
+    bool                 try_lock() 
+                         {
+#ifdef BOOST_HAS_THREADS
+                           uint32_t  tid  = get_thread_id() ; 
+                           uint32_t  zero = 0 ;
+
+                           if ((std::atomic_compare_exchange_strong( &_lock, &zero, tid ) == false) && (zero != tid))
+                             return false ;
+                           _cnt++ ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           if (_cnt == 1)  _acquired( 0, 0, _sampling() ) ;
 #endif
+#endif
+                           return true ;
                          }
     void                 unlock() 
                          {
 #ifdef BOOST_HAS_THREADS
                            _cnt-- ;
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+                           if (_cnt <= 0)
+                             _releasing() ;
+#endif
                            if (_cnt <= 0)
 #if BOOST_OS_LINUX
                              _lock.store( 0 ) ;
@@ -73,7 +218,70 @@ class LockFreeMutex
 #endif
 #endif
                          }
+
+    // thread id of the current holder, 0 when free
+    uint32_t             owner() const { return _lock.load( std::memory_order_relaxed ) ; }
+
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+    LockStats            stats() const
+                         {
+                           LockStats  st ;
+                           st.acquisitions   = _acquisitions.load( std::memory_order_relaxed ) ;
+                           st.contended      = _contended.load( std::memory_order_relaxed ) ;
+                           st.spins          = _spins.load( std::memory_order_relaxed ) ;
+                           st.samples        = _samples.load( std::memory_order_relaxed ) ;
+                           st.wait_ticks     = _wait_ticks.load( std::memory_order_relaxed ) ;
+                           st.max_hold_ticks = _max_hold.load( std::memory_order_relaxed ) ;
+                           return st ;
+                         }
+    uint64_t             waitTicks() const { return _wait_ticks.load( std::memory_order_relaxed ) ; }
+    const char          *name() const { return _name ; }
+
+    // the name must outlive the mutex (a literal, typically).  gates with the
+    // same name are summed by LockStatsRegistry::by_name()
+    void                 set_name( const char *name_ )
+                         {
+                           if (_name)  LockStatsRegistry::instance().remove( _name, this ) ;
+                           _name = name_ ;
+                           if (_name)  LockStatsRegistry::instance().add( _name, this ) ;
+                         }
+
+    // time one outermost acquire in every n (1 = all, 0 = counters only)
+    static void          set_sample_rate( uint32_t n ) { _sample_rate() = n ; }
+#endif
 } ; // class LockFreeMutex
 
+#ifdef BOOST_OBSERVERS_LOCK_STATS
+inline void LockStatsRegistry::add( const std::string &name, const LockFreeMutex *m )
+{
+  std::lock_guard<std::mutex>  sc( _mtx ) ;
+  _live.insert( std::make_pair( name, m )) ;
+} // LockStatsRegistry :: add
+
+inline void LockStatsRegistry::remove( const std::string &name, const LockFreeMutex *m )
+{
+  std::lock_guard<std::mutex>  sc( _mtx ) ;
+  auto  range = _live.equal_range( name ) ;
+  for (auto it = range.first; it != range.second; it++)
+  {
+    if ((*it).second == m)
+    {
+      _retired[ name ].merge( m->stats() ) ;   // keep what a dead gate saw
+      _live.erase( it ) ;
+      return ;
+    }
+  }
+} // LockStatsRegistry :: remove
+
+inline std::map<std::string, LockStats> LockStatsRegistry::by_name()
+{
+  std::lock_guard<std::mutex>  sc( _mtx ) ;
+  std::map<std::string, LockStats>  out( _retired ) ;
+  for (auto &e : _live)
+    out[ e.first ].merge( e.second->stats() ) ;
+  return out ;
+} // LockStatsRegistry :: by_name
+#endif
+
 }} ; // namespace
 
@@ -0,0 +1,248 @@
+/*!
+  @file       mailbox.hpp
+  @brief      AsyncObserver class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "boost/observe/numerics.hpp"
+
+namespace boost { namespace observers {
+
+enum OverflowPolicy
+{
+  OVERFLOW_BLOCK,         // publisher waits for room
+  OVERFLOW_DROP_OLDEST,   // the oldest queued notification is discarded
+  OVERFLOW_DROP_NEWEST,   // the incoming notification is discarded
+  OVERFLOW_CONFLATE       // replaces a queued notification with the same key; drops oldest when full
+} ;
+
+/*!
+  @class AsyncObserver
+
+  <b>Description:</b>
+  decouples a slow observer from its Subject.  invoke() copies the arguments
+  into a bounded mailbox and returns; the wrapped observer runs later, either
+  on the AsyncObserver's own thread (start()) or on whichever thread calls
+  pump(), e.g. a GUI loop.  what happens when the mailbox is full is set by
+  the OverflowPolicy.  depth() and drops() are Numerics, so the backlog can
+  itself be watched.
+
+  <b>Notes:</b>
+  the wrapped observer is owned and deleted with the AsyncObserver.  the
+  conflation key is computed from the notification's arguments, e.g. the
+  symbol of a price update, so a slow reader sees only the latest per key;
+  a notification without arguments has key 0.
+  with OVERFLOW_BLOCK, the wrapped observer must not publish back into the
+  subject that feeds it, or it can wait on itself.  after stop(), a
+  publisher that finds the mailbox full drops its notification rather than
+  wait.  depth() is set under the mailbox lock, so it never goes back to a
+  stale value; its watchers must not post to or pump this mailbox.
+*/
+class AsyncObserver : public Observer
+{
+  public    :
+    typedef std::function<uint64_t( const std::vector<boost::any> & )>   KeyFunc ;
+
+  private   :
+    struct _Msg
+    {
+      std::vector<boost::any>          args ;
+      bool                             has_args ;
+      uint64_t                         key ;
+      uint64_t                         seq ;
+    } ;
+
+    Observer                          *_inner ;
+    size_t                             _capacity ;
+    OverflowPolicy                     _policy ;
+    KeyFunc                            _key ;
+    std::mutex                         _mtx ;
+    std::condition_variable            _not_empty ;
+    std::condition_variable            _not_full ;
+    std::deque<_Msg>                   _q ;
+    uint64_t                           _head_seq ;    // seq of _q.front()
+    std::unordered_map<uint64_t,uint64_t>  _by_key ;  // conflation key -> seq
+    std::thread                        _worker ;
+    std::atomic<bool>                  _running ;
+    boost::observables::Numeric<int64_t>   _depth ;
+    boost::observables::Numeric<uint64_t>  _drops ;
+
+    // caller holds _mtx
+    void                               _pop_front()
+                                       {
+                                         if (_policy == OVERFLOW_CONFLATE)
+                                         {
+                                           auto it = _by_key.find( _q.front().key ) ;
+                                           if ((it != _by_key.end()) && ((*it).second == _head_seq))
+                                             _by_key.erase( it ) ;
+                                         }
+                                         _q.pop_front() ;
+                                         _head_seq++ ;
+                                       }
+    void                               _post( const std::vector<boost::any> *args )
+                                       {
+                                         uint64_t  dropped  = 0 ;
+                                         bool      replaced = false ;
+                                         {
+                                           std::unique_lock<std::mutex>  lk( _mtx ) ;
+                                           uint64_t  key = (_key && args) ? _key( *args ) : 0 ;
+
+                                           if ((_policy == OVERFLOW_CONFLATE) && _key)
+                                           {
+                                             auto it = _by_key.find( key ) ;
+                                             if (it != _by_key.end())
+                                             {
+                                               _Msg  &m = _q[ (*it).second - _head_seq ] ;
+                                               if (args)
+                                                 m.args = *args ;
+                                               else
+                                                 m.args.clear() ;
+                                               m.has_args = (args != nullptr) ;
+                                               replaced   = true ;
+                                             }
+                                           }
+                                           if (!replaced && (_q.size() >= _capacity))
+                                           {
+                                             switch (_policy)
+                                             {
+                                               case OVERFLOW_BLOCK :
+                                                 _not_full.wait( lk, [this](){ return (_q.size() < _capacity) || !_running ; } ) ;
+                                                 if (_q.size() >= _capacity)
+                                                   dropped = 1 ;    // stopped: nobody will make room
+                                                 break ;
+                                               case OVERFLOW_DROP_NEWEST :
+                                                 dropped = 1 ;
+                                                 break ;
+                                               default :
+                                                 _pop_front() ;
+                                                 dropped = 1 ;
+                                                 break ;
+                                             }
+                                           }
+                                           bool  oldest = (_policy == OVERFLOW_DROP_OLDEST) || (_policy == OVERFLOW_CONFLATE) ;
+                                           if (!replaced && (oldest || (dropped == 0)))
+                                           {
+                                             uint64_t  seq = _head_seq + _q.size() ;
+                                             _q.push_back( _Msg{ args ? *args : std::vector<boost::any>(), args != nullptr, key, seq } ) ;
+                                             if (_policy == OVERFLOW_CONFLATE)
+                                               _by_key[ key ] = seq ;
+                                           }
+                                           if (!replaced)
+                                             _depth = (int64_t)_q.size() ;
+                                         }
+                                         if (replaced)
+                                         {
+                                           _drops += 1 ;    // superseded while queued; the depth is unchanged
+                                           return ;
+                                         }
+                                         _not_empty.notify_one() ;
+
+                                         // outside the lock: watchers of drops may do anything
+                                         if (dropped != 0)
+                                           _drops += dropped ;
+                                       }
+    // takes the next message; false if none (and not waiting)
+    bool                               _take( _Msg &m, bool wait )
+                                       {
+                                         {
+                                           std::unique_lock<std::mutex>  lk( _mtx ) ;
+                                           if (wait)
+                                             _not_empty.wait( lk, [this](){ return !_q.empty() || !_running ; } ) ;
+                                           if (_q.empty())
+                                             return false ;
+                                           m = std::move( _q.front()) ;
+                                           _pop_front() ;
+                                           _depth = (int64_t)_q.size() ;
+                                         }
+                                         _not_full.notify_one() ;
+                                         return true ;
+                                       }
+    void                               _deliver( const _Msg &m )
+                                       {
+                                         if (!_inner->enabled())
+                                           return ;
+                                         int  rc = m.has_args ? _inner->invoke( m.args ) : _inner->invoke() ;
+                                         if (rc != 0)
+                                           _inner->disable() ;    // same contract as a Subject
+                                       }
+
+  public    :
+                                       AsyncObserver( Observer *inner, size_t capacity, OverflowPolicy policy = OVERFLOW_BLOCK,
+                                                      const KeyFunc &key = KeyFunc() )
+                                       : _inner( inner ), _capacity( (capacity == 0) ? 1 : capacity ), _policy( policy ), _key( key )
+                                       , _head_seq( 0 ), _running( true )
+                                       {}
+    virtual                           ~AsyncObserver()
+                                       {
+                                         stop() ;
+                                         delete _inner ;
+                                       }
+
+    virtual int                        invoke() { if (_enabled) _post( nullptr ) ; return 0 ; }
+    virtual int                        invoke( const std::vector<boost::any> &args ) { if (_enabled) _post( &args ) ; return 0 ; }
+    virtual const char                *kind() const { return "AsyncObserver" ; }
+    virtual void                      *target() const { return _inner->target() ; }
+    virtual size_t                     target_size() const { return _inner->target_size() ; }
+
+    // delivers queued notifications on a dedicated thread until stop()
+    void                               start()
+                                       {
+                                         if (_worker.joinable())
+                                           return ;
+                                         _running = true ;
+                                         _worker  = std::thread( [this](){
+                                           _Msg  m ;
+                                           while (_take( m, true ))
+                                             _deliver( m ) ;
+                                         }) ;
+                                       }
+    // delivers what is queued, then stops the worker; blocked publishers are released
+    void                               stop()
+                                       {
+                                         {
+                                           std::lock_guard<std::mutex>  lk( _mtx ) ;
+                                           _running = false ;
+                                         }
+                                         _not_empty.notify_all() ;
+                                         _not_full.notify_all() ;
+                                         if (_worker.joinable())
+                                           _worker.join() ;
+                                       }
+    // delivers up to max queued notifications on the calling thread
+    size_t                             pump( size_t max = SIZE_MAX )
+                                       {
+                                         _Msg    m ;
+                                         size_t  n = 0 ;
+                                         while ((n < max) && _take( m, false ))
+                                         {
+                                           _deliver( m ) ;
+                                           n++ ;
+                                         }
+                                         return n ;
+                                       }
+
+    // access methods
+    Observer                          *inner() { return _inner ; }
+    size_t                             capacity() const { return _capacity ; }
+    OverflowPolicy                     policy() const { return _policy ; }
+    boost::observables::Numeric<int64_t>   &depth() { return _depth ; }
+    boost::observables::Numeric<uint64_t>  &drops() { return _drops ; }
+} ; // class AsyncObserver
+
+}} ; // namespace
@@ -0,0 +1,341 @@
+/*!
+  @file       mvcc.hpp
+  @brief      VectorSnapshot / MapSnapshot template definitions
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Multi-version reads for oVector and oMap.  snapshot() returns an immutable
+  view made of shared, read-only pages of up to MVCC_PAGE elements.  The
+  container tracks which pages its writes have touched since the previous
+  snapshot; the next one copies only those and shares every other page with
+  its predecessor.  A page, and with it an old version, is freed when the
+  last snapshot holding it is dropped.
+
+  Readers never lock: a snapshot is a plain value behind a shared_ptr.
+  Writers only set a dirty bit per mutation, and only once a snapshot has
+  been taken.  snapshot() itself takes the container's gate while it copies
+  the dirty pages, so it sees a batch applied under the gate whole or not at
+  all.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace boost { namespace observables {
+
+enum { MVCC_PAGE = 256 } ;      // elements per snapshot page
+
+/*!
+  @class VectorSnapshot< T >
+
+  <b>Description:</b>
+  immutable view of an oVector at the time of snapshot().
+*/
+template <class T>
+class VectorSnapshot
+{
+  public    :
+    typedef std::vector<T>           Page ;
+
+    class const_iterator
+    {
+      private   :
+        const VectorSnapshot        *_s ;
+        size_t                       _i ;
+
+      public    :
+                                     const_iterator( const VectorSnapshot *s, size_t i ) : _s( s ), _i( i ) {}
+
+        const T                     &operator*() const { return (*_s)[ _i ] ; }
+        const T                     *operator->() const { return &(*_s)[ _i ] ; }
+        const_iterator              &operator++() { _i++ ; return *this ; }
+        bool                         operator==( const const_iterator &o ) const { return _i == o._i ; }
+        bool                         operator!=( const const_iterator &o ) const { return _i != o._i ; }
+    } ; // class const_iterator
+
+  private   :
+    std::vector< std::shared_ptr<const Page> >  _pages ;
+    size_t                           _size ;
+    uint64_t                         _version ;
+
+    template <class> friend class VectorVersions ;
+
+  public    :
+                                     VectorSnapshot() : _size( 0 ), _version( 0 ) {}
+
+    const T                         &operator[]( size_t i ) const { return (*_pages[ i / MVCC_PAGE ])[ i % MVCC_PAGE ] ; }
+    const T                         &at( size_t i ) const
+                                     {
+                                       if (i >= _size)
+                                         throw std::out_of_range( "VectorSnapshot::at" ) ;
+                                       return (*this)[ i ] ;
+                                     }
+    const_iterator                   begin() const { return const_iterator( this, 0 ) ; }
+    const_iterator                   end() const { return const_iterator( this, _size ) ; }
+
+    // access methods
+    size_t                           size() const { return _size ; }
+    bool                             empty() const { return _size == 0 ; }
+    uint64_t                         version() const { return _version ; }
+    size_t                           pages() const { return _pages.size() ; }
+    const std::shared_ptr<const Page> &page( size_t n ) const { return _pages[ n ] ; }
+} ; // class VectorSnapshot
+
+/*!
+  @class VectorVersions< T >
+
+  <b>Description:</b>
+  an oVector's side of the snapshots: the latest one and which of its pages
+  have been written since.  created by the first snapshot(); every call is
+  made with the vector's gate held.
+*/
+template <class T>
+class VectorVersions
+{
+  private   :
+    std::shared_ptr<const VectorSnapshot<T> >  _last ;
+    std::vector<bool>                _dirty ;
+    bool                             _all ;
+    bool                             _any ;
+
+  public    :
+                                     VectorVersions() : _all( true ), _any( true ) {}
+
+    void                             dirty( size_t ndx )
+                                     {
+                                       _any = true ;
+                                       if (ndx / MVCC_PAGE < _dirty.size())
+                                         _dirty[ ndx / MVCC_PAGE ] = true ;
+                                     }
+    // an insert or erase at ndx moves every element after it
+    void                             dirty_from( size_t ndx )
+                                     {
+                                       _any = true ;
+                                       for (size_t p = ndx / MVCC_PAGE; p < _dirty.size(); p++)
+                                         _dirty[ p ] = true ;
+                                     }
+    void                             invalidate() { _all = _any = true ; }
+
+    template <class _Vec>
+    std::shared_ptr<const VectorSnapshot<T> >  snapshot( const _Vec &live )
+                                     {
+                                       if (!_any && _last && (_last->size() == live.size()))
+                                         return _last ;
+
+                                       std::shared_ptr<VectorSnapshot<T> >  s = std::make_shared< VectorSnapshot<T> >() ;
+                                       size_t  n  = live.size() ;
+                                       size_t  np = (n + MVCC_PAGE - 1) / MVCC_PAGE ;
+                                       s->_pages.reserve( np ) ;
+                                       for (size_t p = 0; p < np; p++)
+                                       {
+                                         size_t  b = p * MVCC_PAGE ;
+                                         size_t  e = std::min( n, b + MVCC_PAGE ) ;
+                                         if (!_all && _last && (p < _dirty.size()) && !_dirty[ p ] && (_last->_pages[ p ]->size() == e - b))
+                                           s->_pages.push_back( _last->_pages[ p ] ) ;
+                                         else
+                                           s->_pages.push_back( std::make_shared<const typename VectorSnapshot<T>::Page>( live.begin() + b, live.begin() + e )) ;
+                                       }
+                                       s->_size    = n ;
+                                       s->_version = _last ? _last->_version + 1 : 1 ;
+
+                                       _last = s ;
+                                       _dirty.assign( np, false ) ;
+                                       _all = _any = false ;
+                                       return _last ;
+                                     }
+} ; // class VectorVersions
+
+/*!
+  @class MapSnapshot< Key, Value, _Pr >
+
+  <b>Description:</b>
+  immutable view of an oMap at the time of snapshot().  entries are held in
+  key order, in pages; page i holds the keys from its first up to the first
+  of page i+1.  find() is two binary searches.
+*/
+template <class Key, class Value, class _Pr = std::less<Key> >
+class MapSnapshot
+{
+  public    :
+    typedef std::pair<Key, Value>    value_type ;
+    struct Page
+    {
+      std::vector<value_type>        entries ;
+    } ;
+
+    class const_iterator
+    {
+      private   :
+        const MapSnapshot           *_s ;
+        size_t                       _p ;
+        size_t                       _i ;
+
+      public    :
+                                     const_iterator( const MapSnapshot *s, size_t p, size_t i ) : _s( s ), _p( p ), _i( i ) {}
+
+        const value_type            &operator*() const { return _s->_pages[ _p ]->entries[ _i ] ; }
+        const value_type            *operator->() const { return &_s->_pages[ _p ]->entries[ _i ] ; }
+        const_iterator              &operator++()
+                                     {
+                                       if (++_i == _s->_pages[ _p ]->entries.size())
+                                       {
+                                         _p++ ;
+                                         _i = 0 ;
+                                       }
+                                       return *this ;
+                                     }
+        bool                         operator==( const const_iterator &o ) const { return (_p == o._p) && (_i == o._i) ; }
+        bool                         operator!=( const const_iterator &o ) const { return !(*this == o) ; }
+    } ; // class const_iterator
+
+  private   :
+    std::vector< std::shared_ptr<const Page> >  _pages ;      // never empty pages
+    size_t                           _size ;
+    uint64_t                         _version ;
+    _Pr                              _pr ;
+
+    template <class, class, class> friend class MapVersions ;
+
+    // the page whose range holds k
+    size_t                           _page_of( const Key &k ) const
+                                     {
+                                       size_t  p = std::upper_bound( _pages.begin(), _pages.end(), k,
+                                                     [this]( const Key &x, const std::shared_ptr<const Page> &pg ){
+                                                       return _pr( x, pg->entries.front().first ) ;
+                                                     }) - _pages.begin() ;
+                                       return (p == 0) ? 0 : p - 1 ;
+                                     }
+
+  public    :
+                                     MapSnapshot() : _size( 0 ), _version( 0 ) {}
+
+    // the entry for k, or nullptr
+    const value_type                *find( const Key &k ) const
+                                     {
+                                       if (_pages.empty())
+                                         return nullptr ;
+                                       const std::vector<value_type>  &v = _pages[ _page_of( k ) ]->entries ;
+                                       auto  it = std::lower_bound( v.begin(), v.end(), k, [this]( const value_type &e, const Key &x ){
+                                                    return _pr( e.first, x ) ;
+                                                  }) ;
+                                       return ((it != v.end()) && !_pr( k, (*it).first )) ? &(*it) : nullptr ;
+                                     }
+    size_t                           count( const Key &k ) const { return (find( k ) != nullptr) ? 1 : 0 ; }
+    const Value                     &at( const Key &k ) const
+                                     {
+                                       const value_type  *e = find( k ) ;
+                                       if (e == nullptr)
+                                         throw std::out_of_range( "MapSnapshot::at" ) ;
+                                       return e->second ;
+                                     }
+    const_iterator                   begin() const { return const_iterator( this, 0, 0 ) ; }
+    const_iterator                   end() const { return const_iterator( this, _pages.size(), 0 ) ; }
+
+    // access methods
+    size_t                           size() const { return _size ; }
+    bool                             empty() const { return _size == 0 ; }
+    uint64_t                         version() const { return _version ; }
+    size_t                           pages() const { return _pages.size() ; }
+    const std::shared_ptr<const Page> &page( size_t n ) const { return _pages[ n ] ; }
+} ; // class MapSnapshot
+
+/*!
+  @class MapVersions< Key, Value, _Pr >
+
+  <b>Description:</b>
+  an oMap's side of the snapshots.  a write to key k dirties the page of the
+  latest snapshot whose range holds k; the next snapshot rebuilds just those
+  key ranges from the live map, splitting any that grew past a page.  every
+  call is made with the map's gate held.
+*/
+template <class Key, class Value, class _Pr = std::less<Key> >
+class MapVersions
+{
+  private   :
+    typedef MapSnapshot<Key, Value, _Pr>  _Snap ;
+    typedef typename _Snap::Page          _Page ;
+
+    std::shared_ptr<const _Snap>     _last ;
+    std::vector<bool>                _dirty ;
+    bool                             _all ;
+    bool                             _any ;
+
+    template <class _It>
+    static void                      _pages( std::vector< std::shared_ptr<const _Page> > &out, _It f, _It l )
+                                     {
+                                       // evenly: a full page that gains a key splits in two halves, not 256 + 1
+                                       size_t  n  = std::distance( f, l ) ;
+                                       size_t  np = (n + MVCC_PAGE - 1) / MVCC_PAGE ;
+                                       for (size_t p = 0; p < np; p++)
+                                       {
+                                         size_t  m = n / np + ((p < n % np) ? 1 : 0) ;
+                                         std::shared_ptr<_Page>  pg = std::make_shared<_Page>() ;
+                                         pg->entries.reserve( m ) ;
+                                         for (; m-- > 0; ++f)
+                                           pg->entries.emplace_back( (*f).first, (*f).second ) ;
+                                         out.push_back( pg ) ;
+                                       }
+                                     }
+
+  public    :
+                                     MapVersions() : _all( true ), _any( true ) {}
+
+    void                             dirty( const Key &k )
+                                     {
+                                       _any = true ;
+                                       if (!_all && _last && !_last->_pages.empty())
+                                         _dirty[ _last->_page_of( k ) ] = true ;
+                                       else
+                                         _all = true ;    // no pages to place k in yet
+                                     }
+    void                             invalidate() { _all = _any = true ; }
+
+    template <class _Map>
+    std::shared_ptr<const _Snap>     snapshot( const _Map &live )
+                                     {
+                                       if (!_any && _last)
+                                         return _last ;
+
+                                       std::shared_ptr<_Snap>  s = std::make_shared<_Snap>() ;
+                                       // many erases leave many small pages; repack them all
+                                       if (_last && (_last->_pages.size() > 2 * (live.size() / MVCC_PAGE) + 2))
+                                         _all = true ;
+                                       if (_all || !_last)
+                                         _pages( s->_pages, live.begin(), live.end() ) ;
+                                       else
+                                       {
+                                         const auto  &old = _last->_pages ;
+                                         for (size_t p = 0; p < old.size(); p++)
+                                         {
+                                           if (!_dirty[ p ])
+                                           {
+                                             s->_pages.push_back( old[ p ] ) ;
+                                             continue ;
+                                           }
+                                           auto  f = (p == 0) ? live.begin() : live.lower_bound( old[ p ]->entries.front().first ) ;
+                                           auto  l = (p + 1 == old.size()) ? live.end() : live.lower_bound( old[ p + 1 ]->entries.front().first ) ;
+                                           _pages( s->_pages, f, l ) ;
+                                         }
+                                       }
+                                       s->_size    = live.size() ;
+                                       s->_version = _last ? _last->_version + 1 : 1 ;
+
+                                       _last = s ;
+                                       _dirty.assign( s->_pages.size(), false ) ;
+                                       _all = _any = false ;
+                                       return _last ;
+                                     }
+} ; // class MapVersions
+
+}} ; // namespace
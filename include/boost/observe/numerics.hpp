@@ -12,7 +12,9 @@
 #ifndef NUMERICS_H
 #define NUMERICS_H
 
+#include <chrono>
 #include "boost/observe/subject.hpp"
+#include "boost/observe/parking.hpp"
 
 /*!
   @class Numeric< T >::DivByZero
@@ -27,128 +29,162 @@
 */
 namespace boost { namespace observables {
 
-template <class T> 
+template <class T, class _Gate = LockFreeMutex> 
 class Numeric 
 {
   protected :
-    std::atomic<T>      _x ;
-    Subject             _valueCB ;
+    typename gate_traits<_Gate>::template atomic<T>  _x ;
+    basic_subject<_Gate>  _valueCB ;
+
+    // wakes threads blocked in wait_for_change / wait_until; costs a load unless
+    // one of them is parked on this value
+    void                _wake()
+                        {
+                          if constexpr (gate_traits<_Gate>::threaded)
+                            ParkingLot::instance().unpark_all( this ) ;
+                        }
+
+    // applies op to the current value and notifies watchers with { new, old, this }.
+    // a trampolined subject is notified after the lock is dropped, so the cascade
+    // downstream of this value does not run while we still hold it.  waiters are
+    // woken as soon as the value is stored, so a throwing watcher cannot strand them
+    template <class Op>
+    void                _update( Op op )
+                        {
+                          if (_valueCB.nWatchers() == 0)
+                          {
+                            _x = op( _x.load() ) ;
+                            _valueCB.touch() ;      // pollers still see it
+                            _wake() ;
+                            return ;
+                          }
+
+                          T  nu, old ;
+                          {
+                            lock_guard<_Gate>  sc( _valueCB.lock() ) ;
+                            old = _x.load() ;
+                            nu  = op( old ) ;
+                            _x  = nu ;
+                            _wake() ;
+                            if (!_valueCB.trampolined())
+                            {
+                              _valueCB.invoke({ nu, old, (void*)this }) ;
+                              return ;
+                            }
+                          }
+                          _valueCB.invoke({ nu, old, (void*)this }) ;
+                        }
 
   public    :
                         Numeric() : _valueCB(this), _x( 0 ) {}
-                        Numeric( const std::atomic<T> &x ) : _valueCB(this), _x( x ) {}
-                        Numeric( const Numeric<T> &i ) : _valueCB(this), _x( i._x ) {}
+                        Numeric( const std::atomic<T> &x ) : _valueCB(this), _x( x.load() ) {}
+                        Numeric( const Numeric &i ) : _valueCB(this), _x( i._x.load() ) {}
                        ~Numeric() {}
 
     inline bool         is_watched() const { return (_valueCB.nWatchers() > 0) ; }
-    Subject            &valueCB() { return _valueCB ; }
-    Subject            &operator<< ( boost::observers::Observer *o ) { _valueCB << o ; return _valueCB ; }
+    basic_subject<_Gate>  &valueCB() { return _valueCB ; }
+    // bumped by every change of value, watched or not; see ChangeCursor
+    uint64_t            version() { return _valueCB.version() ; }
+    const std::atomic<uint64_t>  &version_counter() { return _valueCB.version_counter() ; }
+    basic_subject<_Gate>  &operator<< ( boost::observers::Observer *o ) { _valueCB << o ; return _valueCB ; }
+
+    // blocking waits for threads, without installing an observer.  waiters
+    // park on a ParkingLot stripe; a write costs one extra load until one does
+    T                   wait_for_change( const T &old ) const       // returns the new value
+                        {
+                          static_assert( gate_traits<_Gate>::threaded, "waiting needs a threaded gate" ) ;
+                          T  v = old ;
+                          ParkingLot::instance().park( this, [&](){ return (v = _x.load()) != old ; } ) ;
+                          return v ;
+                        }
+    template <class Pred>
+    void                wait_until( Pred p ) const
+                        {
+                          static_assert( gate_traits<_Gate>::threaded, "waiting needs a threaded gate" ) ;
+                          ParkingLot::instance().park( this, [&](){ return p( _x.load() ) ; } ) ;
+                        }
+    // false if p( value ) still fails after timeout
+    template <class Pred, class Rep, class Period>
+    bool                wait_until( Pred p, const std::chrono::duration<Rep, Period> &timeout ) const
+                        {
+                          static_assert( gate_traits<_Gate>::threaded, "waiting needs a threaded gate" ) ;
+                          return ParkingLot::instance().park( this, [&](){ return p( _x.load() ) ; },
+                                                              std::chrono::steady_clock::now() + timeout ) ;
+                        }
+
+#ifdef BOOST_OBSERVERS_HAS_COROUTINES
+    // co_await x.when( [](T v){ return v > limit ; } ) ;  see awaitable.hpp
+    template <class Pred>
+    ValueAwaiter<T, Pred>  when( Pred p, const Executor &e = Executor() ) { return ValueAwaiter<T, Pred>( _valueCB, _x, p, e ) ; }
+    ChangeStream<T>     changes( size_t max_backlog = 0, const Executor &e = Executor() ) { return ChangeStream<T>( _valueCB, max_backlog, e ) ; }
+#endif
 
     // comparison operators
     bool                operator==( const T &x ) const { return (_x == x) ; }
-    bool                operator==( const Numeric<T> &i ) const { return (_x == i._x) ; }
+    bool                operator==( const Numeric &i ) const { return (_x == i._x) ; }
     bool                operator!=( const T &x ) const { return (_x != x) ; }
-    bool                operator!=( const Numeric<T> &i ) const { return (_x != i._x) ; }
+    bool                operator!=( const Numeric &i ) const { return (_x != i._x) ; }
     bool                operator< ( const T &x ) const { return (_x < x) ; }
-    bool                operator< ( const Numeric<T> &i ) const { return (_x < i._x) ; }
+    bool                operator< ( const Numeric &i ) const { return (_x < i._x) ; }
     bool                operator<=( const T &x ) const { return (_x <= x) ; }
-    bool                operator<=( const Numeric<T> &i ) const { return (_x <= i._x) ; }
+    bool                operator<=( const Numeric &i ) const { return (_x <= i._x) ; }
     bool                operator> ( const T &x ) const { return (_x > x) ; }
-    bool                operator> ( const Numeric<T> &i ) const { return (_x > i._x) ; }
+    bool                operator> ( const Numeric &i ) const { return (_x > i._x) ; }
     bool                operator>=( const T &x ) const { return (_x >= x) ; }
-    bool                operator>=( const Numeric<T> &i ) const { return (_x >= i._x) ; }
+    bool                operator>=( const Numeric &i ) const { return (_x >= i._x) ; }
 
     // assignment operators
-    Numeric<T>   &operator= ( const std::atomic<T> &x ) 
+    Numeric      &operator= ( const std::atomic<T> &x ) 
                         {
-                          if (_x == x)  return *this ;
-                          if (_valueCB.nWatchers() > 0)
-                          {
-                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
-                            std::atomic<T>  old( _x.load() ) ;
-                            _x = x.load() ;
-                            _valueCB.invoke({ _x.load(), old.load(), (void*)this }) ;
-                          }
-                          else
-                            _x = x.load() ;
+                          T  v = x.load() ;
+                          if (_x == v)  return *this ;
+                          _update( [v]( const T & ){ return v ; } ) ;
                           return *this ;
                         } 
-    Numeric<T>   &operator= ( const Numeric<T> &i ) { return (*this = i._x) ; }
-    Numeric<T>   &operator+= ( const T &x ) 
+    Numeric      &operator= ( const Numeric &i ) { return (*this = i._x.load()) ; }
+    Numeric      &operator+= ( const T &x ) 
                         {
                           if (x == 0)  return *this ;
-                          if (_valueCB.nWatchers() > 0)
-                          {
-                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
-                            std::atomic<T>  old( _x.load() ) ;
-                            _x = _x.load() + x ;
-                            _valueCB.invoke({ _x.load(), old.load(), (void*)this }) ;
-                          }
-                          else
-                            _x = _x.load() + x ;
+                          _update( [&x]( const T &v ){ return v + x ; } ) ;
                           return *this ;
                         } 
-    Numeric<T>   &operator+= ( const Numeric<T> &i ) { return (*this += i._x) ; }
-    Numeric<T>   &operator-= ( const T &x ) 
+    Numeric      &operator+= ( const Numeric &i ) { return (*this += i._x) ; }
+    Numeric      &operator-= ( const T &x ) 
                         {
                           if (x == 0)  return *this ;
-                          if (_valueCB.nWatchers() > 0)
-                          {
-                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
-                            std::atomic<T>  old( _x ) ;
-                            _x = _x.load - x ;
-                            _valueCB.invoke({ _x.load(), old.load(), (void*)this }) ;
-                          }
-                          else
-                            _x = _x.load - x ;
+                          _update( [&x]( const T &v ){ return v - x ; } ) ;
                           return *this ;
                         } 
-    Numeric<T>   &operator-= ( const Numeric<T>  &i ) { return (*this -= i._x) ; }
-    Numeric<T>   &operator*= ( const T &x ) 
+    Numeric      &operator-= ( const Numeric &i ) { return (*this -= i._x) ; }
+    Numeric      &operator*= ( const T &x ) 
                         {
                           if (x == 1)  return *this ;
-                          if (_valueCB.nWatchers() > 0)
-                          {
-                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
-                            std::atomic<T>  old( _x ) ;
-                            _x = _x.load * x ;
-                            _valueCB.invoke({ _x.load(), old.load(), (void*)this }) ;
-                          }
-                          else
-                            _x = _x.load * x ;
+                          _update( [&x]( const T &v ){ return v * x ; } ) ;
                           return *this ;
                         } 
-    Numeric<T>   &operator*= ( const Numeric<T> &i ) { return (*this *= i._x) ; }
-    Numeric<T>   &operator/= ( const T &x ) 
+    Numeric      &operator*= ( const Numeric &i ) { return (*this *= i._x) ; }
+    Numeric      &operator/= ( const T &x ) 
                         {
                           if (x == 0)  throw Numeric::DivByZero() ;
                           if (x == 1)  return *this ;
-                          if (_valueCB.nWatchers() > 0)
-                          {
-                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
-                            std::atomic<T>  old( _x ) ;
-                            _x = _x.load / x ;
-                            _valueCB.invoke({ _x.load(), old.load(), (void*)this }) ;
-                          }
-                          else
-                            _x = _x.load / x ;
+                          _update( [&x]( const T &v ){ return v / x ; } ) ;
                           return *this ;
                         } 
-    Numeric<T>   &operator/= ( const Numeric<T> &i ) { return (*this /= i._x) ; }
-    Numeric<T>   &operator++ () { return (*this += 1) ; }
-    Numeric<T>   &operator++ ( int junk ) { return (*this += 1) ; }
-    Numeric<T>   &operator-- () { return (*this -= 1) ; }
-    Numeric<T>   &operator-- ( int junk ) { return (*this -= 1) ; }
+    Numeric      &operator/= ( const Numeric &i ) { return (*this /= i._x) ; }
+    Numeric      &operator++ () { return (*this += 1) ; }
+    Numeric      &operator++ ( int junk ) { return (*this += 1) ; }
+    Numeric      &operator-- () { return (*this -= 1) ; }
+    Numeric      &operator-- ( int junk ) { return (*this -= 1) ; }
 
     // pass thru operators
     T                   operator+ ( const T &x ) const { return (_x + x) ; }
-    T                   operator+ ( const Numeric<T> &i ) const { return (i._x + _x) ; }
+    T                   operator+ ( const Numeric &i ) const { return (i._x + _x) ; }
     T                   operator- ( const T &x ) const { return (_x - x) ; }
-    T                   operator- ( const Numeric<T> &i ) const { return (_x - i._x) ; }
+    T                   operator- ( const Numeric &i ) const { return (_x - i._x) ; }
     T                   operator* ( const T &x ) const { return (_x * x) ; }
-    T                   operator* ( const Numeric<T> &i ) const { return (i._x * _x) ; }
+    T                   operator* ( const Numeric &i ) const { return (i._x * _x) ; }
     T                   operator/ ( const T &x ) const { if (x == 0) throw DivByZero() ; return (_x / x) ; }
-    T                   operator/ ( const Numeric<T> &i ) const { if (i._x == 0) throw DivByZero() ; return (_x / i._x) ; }
+    T                   operator/ ( const Numeric &i ) const { if (i._x == 0) throw DivByZero() ; return (_x / i._x) ; }
 
     // cast operators
                         operator T() const { return _x ; }
@@ -161,6 +197,11 @@ class Numeric
     } ; // Numeric Exception class
 } ; // class Numeric
 
+#if defined(BOOST_HAS_THREADS) && !defined(BOOST_OBSERVERS_LOCK_STATS)
+// an unwatched Numeric<double> is the value plus a compact Subject: 4 pointers
+static_assert( sizeof(Numeric<double>) <= 4 * sizeof(void*), "Numeric<double> exceeds its 4-pointer budget" ) ;
+#endif
+
 }} ; // namespace
 
 #endif
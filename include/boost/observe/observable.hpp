@@ -0,0 +1,204 @@
+/*!
+  @file       observable.hpp
+  @brief      Observable template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include "boost/observe/subject.hpp"
+
+namespace boost { namespace observables {
+
+// largest trivially-copyable T kept inline under a seqlock; bigger ones are shared
+enum { OBSERVABLE_SEQLOCK_MAX = 128 } ;
+
+namespace detail {
+
+/*!
+  seqlock storage: T lives in relaxed atomic words guarded by a sequence
+  number that is odd while a write is in progress.  readers never block or
+  write shared memory; they retry if a write overlapped their copy.  writers
+  must be serialized by the caller.
+*/
+template <class T>
+class SeqlockValue
+{
+  private   :
+    enum { N_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t) } ;
+
+    std::atomic<uint64_t>            _seq ;
+    std::atomic<uint64_t>            _w[ N_WORDS ] ;
+
+  public    :
+                                     SeqlockValue( const T &v ) : _seq( 0 ) { store( v ) ; }
+
+    T                                load() const
+                                     {
+                                       uint64_t  buf[ N_WORDS ] ;
+                                       T         v ;
+                                       uint64_t  s1, s2 ;
+                                       do
+                                       {
+                                         while ((s1 = _seq.load( std::memory_order_acquire )) & 1)
+                                           ;
+                                         for (size_t i = 0; i < N_WORDS; i++)
+                                           buf[i] = _w[i].load( std::memory_order_relaxed ) ;
+                                         std::atomic_thread_fence( std::memory_order_acquire ) ;
+                                         s2 = _seq.load( std::memory_order_relaxed ) ;
+                                       } while (s1 != s2) ;
+                                       memcpy( (void *)&v, buf, sizeof(T) ) ;
+                                       return v ;
+                                     }
+    std::shared_ptr<const T>         ptr() const { return std::make_shared<const T>( load() ) ; }
+    void                             store( const T &v )
+                                     {
+                                       uint64_t  buf[ N_WORDS ] = { 0 } ;
+                                       uint64_t  s = _seq.load( std::memory_order_relaxed ) ;
+
+                                       memcpy( buf, (const void *)&v, sizeof(T) ) ;
+                                       _seq.store( s + 1, std::memory_order_relaxed ) ;
+                                       std::atomic_thread_fence( std::memory_order_release ) ;
+                                       for (size_t i = 0; i < N_WORDS; i++)
+                                         _w[i].store( buf[i], std::memory_order_relaxed ) ;
+                                       _seq.store( s + 2, std::memory_order_release ) ;
+                                     }
+} ; // class SeqlockValue
+
+/*!
+  shared storage: an immutable T behind a shared_ptr that is swapped
+  atomically.  readers take a reference and keep it for as long as they need
+  the value; a writer never touches an object a reader can see.
+*/
+template <class T>
+class SharedValue
+{
+  private   :
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic< std::shared_ptr<const T> >  _p ;
+#else
+    std::shared_ptr<const T>         _p ;
+#endif
+
+  public    :
+                                     SharedValue( const T &v ) : _p( std::make_shared<const T>( v )) {}
+
+    std::shared_ptr<const T>         ptr() const
+                                     {
+#if defined(__cpp_lib_atomic_shared_ptr)
+                                       return _p.load( std::memory_order_acquire ) ;
+#else
+                                       return std::atomic_load_explicit( &_p, std::memory_order_acquire ) ;
+#endif
+                                     }
+    void                             set( std::shared_ptr<const T> p )
+                                     {
+#if defined(__cpp_lib_atomic_shared_ptr)
+                                       _p.store( std::move( p ), std::memory_order_release ) ;
+#else
+                                       std::atomic_store_explicit( &_p, std::move( p ), std::memory_order_release ) ;
+#endif
+                                     }
+    T                                load() const { return *ptr() ; }
+    void                             store( const T &v ) { set( std::make_shared<const T>( v )) ; }
+} ; // class SharedValue
+
+} // namespace detail
+
+/*!
+  @class Observable< T >
+
+  <b>Description:</b>
+  Numeric< T > for any copyable T: strings, structs such as a Quote, or large
+  objects.  readers never lock.  small trivially-copyable types are held
+  inline under a seqlock, everything else as an atomically swapped
+  shared_ptr< const T >.  either way a reader gets a consistent value, never a
+  torn mix of two writes.
+
+  watchers of valueCB() receive { const T *new, const T *old, this }.  the
+  pointers are valid only for the duration of the callback; copy the value if
+  it must outlive it, or take ptr() to hold the current value without
+  copying it (for seqlocked types ptr() copies; they are small).  on a
+  trampolined valueCB the arguments are followed by two shared_ptr< const T >
+  that keep the values alive until dispatch.
+
+  <b>Notes:</b>
+  writers serialize on the valueCB lock, as Numeric's do.  modify( f ) is a
+  read-copy-update: f is applied to a private copy which then replaces the
+  current value in a single store.
+*/
+template <class T>
+class Observable
+{
+  public    :
+    enum { SEQLOCK = std::is_trivially_copyable<T>::value && (sizeof(T) <= OBSERVABLE_SEQLOCK_MAX) } ;
+
+  protected :
+    typedef typename std::conditional< SEQLOCK, detail::SeqlockValue<T>, detail::SharedValue<T> >::type  _Store ;
+
+    _Store              _x ;
+    Subject             _valueCB ;
+
+    // writes op( old ) and notifies watchers with { &new, &old, this }.  same
+    // locking and trampoline behaviour as Numeric::_update; a deferred
+    // notification also carries shared_ptrs that keep both values alive
+    template <class Op>
+    void                _update( Op op )
+                        {
+                          std::shared_ptr<const T>  nu, old ;
+                          {
+                            lock_guard<LockFreeMutex>  sc( _valueCB.lock() ) ;
+                            if (_valueCB.nWatchers() == 0)
+                            {
+                              _x.store( op( _x.load() )) ;
+                              return ;
+                            }
+
+                            T  o = _x.load() ;
+                            T  n = op( o ) ;
+                            _x.store( n ) ;
+                            if (!_valueCB.trampolined())
+                            {
+                              _valueCB.invoke({ (const T *)&n, (const T *)&o, (void*)this }) ;
+                              return ;
+                            }
+                            nu  = std::make_shared<const T>( std::move( n )) ;
+                            old = std::make_shared<const T>( std::move( o )) ;
+                          }
+                          _valueCB.invoke({ nu.get(), old.get(), (void*)this, nu, old }) ;
+                        }
+
+  public    :
+                        Observable() : _x( T() ), _valueCB( this ) {}
+                        Observable( const T &x ) : _x( x ), _valueCB( this ) {}
+                        Observable( const Observable<T> &o ) : _x( o.get() ), _valueCB( this ) {}
+                       ~Observable() {}
+
+    inline bool         is_watched() const { return (_valueCB.nWatchers() > 0) ; }
+    Subject            &valueCB() { return _valueCB ; }
+    Subject            &operator<< ( boost::observers::Observer *o ) { _valueCB << o ; return _valueCB ; }
+
+    // readers
+    T                   get() const { return _x.load() ; }
+    std::shared_ptr<const T>  ptr() const { return _x.ptr() ; }
+                        operator T() const { return _x.load() ; }
+
+    // writers
+    Observable<T>      &operator= ( const T &x ) { set( x ) ; return *this ; }
+    Observable<T>      &operator= ( const Observable<T> &o ) { set( o.get() ) ; return *this ; }
+    void                set( const T &x ) { _update( [&x]( const T & ){ return x ; } ) ; }
+    template <class F>
+    void                modify( F f ) { _update( [&f]( const T &old ){ T  v( old ) ; f( v ) ; return v ; } ) ; }
+} ; // class Observable
+
+}} ; // namespace
@@ -11,6 +11,7 @@
 */
 #pragma once
 
+#include <stdint.h>
 #include <vector>
 #include <functional>
 #include <stdarg.h> 
@@ -22,16 +23,49 @@ class Observer
 {
   protected :
     bool                     _enabled ;
+    bool                     _expired ;      // one-shot observer has fired; owning Subject deletes it
+    bool                     _parallel ;     // may run on a WorkPool thread, concurrently with its siblings
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+    uint64_t                 _n_invokes ;    // times dispatched by its Subject
+    uint64_t                 _ticks ;        // cumulative handler time (tsc ticks)
+#endif
 
   public    :
-                             Observer() { _enabled = true  ; }
+                             Observer() 
+                             { _enabled = true  ; 
+                               _expired = false ;
+                               _parallel = false ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                               _n_invokes = 0 ;
+                               _ticks     = 0 ;
+#endif
+                             }
     virtual                 ~Observer() { _enabled = false ; }
 
     virtual void             disable(){ _enabled = false ; }
     virtual void             enable() { _enabled = true  ; }
     virtual bool             enabled(){ return _enabled  ; }
+    void                     expire() { _enabled = false ; _expired = true ; }
+    bool                     expired() const { return _expired ; }
+    // declares that invoke() may run on another thread, alongside the subject's
+    // other parallel-safe observers; see basic_subject::set_parallel()
+    Observer                *set_parallel_safe( bool b = true ) { _parallel = b ; return this ; }
+    bool                     parallel_safe() const { return _parallel ; }
     virtual int              invoke() = 0 ;
     virtual int              invoke( const std::vector<boost::any> &args ) = 0 ;
+
+    // introspection: the object a member-function observer calls into (and its
+    // size, so the graph walker can tell which subjects that object embeds)
+    virtual const char      *kind() const { return "Observer" ; }
+    virtual void            *target() const { return nullptr ; }
+    virtual size_t           target_size() const { return 0 ; }
+
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+    // called by the owning Subject, under its lock
+    void                     record( uint64_t ticks ) { _n_invokes++ ; _ticks += ticks ; }
+    uint64_t                 nInvokes() const { return _n_invokes ; }
+    uint64_t                 ticks() const { return _ticks ; }
+#endif
 } ; // class Observer
 
 typedef std::vector<Observer*>            ObserverVec ;
@@ -47,6 +81,7 @@ class LambdaPoke : public Observer
 
     virtual int              invoke() { if (_enabled && (_pf != nullptr)) _pf() ; return 0 ; } 
     virtual int              invoke( const std::vector<boost::any> &args ) { if (_enabled && (_pf != nullptr)) _pf() ; return 0 ; } 
+    virtual const char      *kind() const { return "LambdaPoke" ; }
 } ; // class LambdaPoke
 
 template <class T>
@@ -61,6 +96,9 @@ class MemberPoke : public Observer
 
     virtual int              invoke() { if (_enabled && (_pf != nullptr) && (_obj != nullptr)) (_obj->*_pf)() ; return 0 ; } 
     virtual int              invoke( const std::vector<boost::any> &args ) { if (_enabled && (_pf != nullptr) && (_obj != nullptr)) (_obj->*_pf)() ; return 0 ; } 
+    virtual const char      *kind() const { return "MemberPoke" ; }
+    virtual void            *target() const { return _obj ; }
+    virtual size_t           target_size() const { return sizeof(T) ; }
 } ; // class MemberPoke
 
 class Lambda : public Observer
@@ -73,6 +111,7 @@ class Lambda : public Observer
 
     virtual int              invoke() { if (_enabled && (_pf != nullptr)) _pf({}) ; return 0 ; } 
     virtual int              invoke( const std::vector<boost::any> &args ) { if (_enabled && (_pf != nullptr)) _pf(args) ; return 0 ; } 
+    virtual const char      *kind() const { return "Lambda" ; }
 } ; // class Lambda
 
 template <class T>
@@ -99,6 +138,9 @@ class MemberFunc : public Observer
                                }
                                return 0 ; 
                              } 
+    virtual const char      *kind() const { return "MemberFunc" ; }
+    virtual void            *target() const { return _obj ; }
+    virtual size_t           target_size() const { return sizeof(T) ; }
 } ; // class MemberFunc
 
 class WinLambda : public Observer
@@ -121,6 +163,7 @@ class WinLambda : public Observer
                                }
                                return 0 ; 
                              } 
+    virtual const char      *kind() const { return "WinLambda" ; }
 } ; // class WinLambda
 
 template <class T>
@@ -146,6 +189,9 @@ class WinMemberFunc : public Observer
                                }
                                return 0 ; 
                              } 
+    virtual const char      *kind() const { return "WinMemberFunc" ; }
+    virtual void            *target() const { return _obj ; }
+    virtual size_t           target_size() const { return sizeof(T) ; }
 } ; // class WinMemberFunc
 
 }} ;
@@ -12,71 +12,317 @@
 #pragma once
 
 #include <boost/observe/subject.hpp>
+#include <boost/observe/watch.hpp>
+#include <boost/observe/mvcc.hpp>
+#include <functional>
 #include <map>
+#include <memory>
+#include <utility>
 
 namespace boost { namespace observables {
 
-template <class Key, class Value, class _Pr = std::less<Key> >
+template <class Key, class Value, class _Pr = std::less<Key>, class _Gate = LockFreeMutex >
 class oMap : public std::map< Key, Value, _Pr >
 {
+  public:
+    typedef basic_subject< _Gate >                       Subject ;
+
   protected:
-    typedef typename oMap<Key,Value,_Pr>::iterator       gomap_iter ;
-    typedef typename oMap< Key, Value, _Pr >::value_type gomap_pair ;
+    typedef std::map< Key, Value, _Pr >                  _Parent ;
+    typedef typename _Parent::iterator                   gomap_iter ;
+    typedef typename _Parent::value_type                 gomap_pair ;
+    typedef WatchIndex< Key, _Pr, _Gate >                _Watches ;
+    typedef MapVersions< Key, Value, _Pr >               _Versions ;
     Subject             _preEraseCB;
     Subject             _postInsertCB;
+    Subject             _updateCB;        // value of an existing key replaced in place
+    Subject             _resetCB;         // contents replaced in bulk; no per-element notifications
 #ifdef BOOST_HAS_THREADS
-    LockFreeMutex       _gate;
+    _Gate               _gate;
 #endif
     gomap_iter          _current;
+    std::unique_ptr<_Watches>  _watches;  // per-key and key-range subjects; null until the first watch
+    std::unique_ptr<_Versions> _versions; // pages written since the last snapshot; null until the first snapshot
+    std::atomic<uint64_t>      _version;  // bumped by every tracked change; see ChangeCursor
+
+    // tells the watches scoped to its key; lock held
+    void                _changed( gomap_iter it, ChangeKind kind )
+                        {
+                          _bump();
+                          if( _versions )
+                          {
+                            _versions->dirty( (*it).first ) ;
+                          }
+                          if( _watches )
+                          {
+                            _watches->for_each( (*it).first, [&]( Subject &s ){ s.invoke({ it, kind, this }) ; } ) ;
+                          }
+                        }
+
+    _Watches           &_watch_index()
+                        {
+                          if( !_watches )
+                          {
+                            _watches.reset( new _Watches( this ) );
+                          }
+                          return( *_watches );
+                        }
+    void                _bump()
+                        {
+                          _version.fetch_add( 1, std::memory_order_release );
+                        }
+    void                _reshaped()
+                        {
+                          _bump();
+                          if( _versions )
+                          {
+                            _versions->invalidate() ;
+                          }
+                        }
 
   public:
+    typedef typename _Parent::node_type                  node_type ;
+    typedef MapSnapshot< Key, Value, _Pr >               snapshot_type ;
+
                         oMap() 
-                        : _preEraseCB(this), _postInsertCB(this) 
+                        : _preEraseCB(this), _postInsertCB(this), _updateCB(this), _resetCB(this), _version(0)
                         {}
                         oMap( const oMap &other_ )
-                        : _preEraseCB(this), _postInsertCB(this) 
+                        : _preEraseCB(this), _postInsertCB(this), _updateCB(this), _resetCB(this), _version(0)
                         {
                           *this = other_;
                         }
+                        // takes other's nodes as they are: no per-element notifications.
+                        // observers stay with the object they were installed on; other's
+                        // resetCB fires, as its contents are gone
+                        oMap( oMap &&other_ )
+                        : _preEraseCB(this), _postInsertCB(this), _updateCB(this), _resetCB(this), _version(0)
+                        {
+                          {
+#ifdef BOOST_HAS_THREADS
+                            lock_guard<_Gate>  sc( other_._gate ) ;
+#endif
+                            _Parent::swap( other_ );
+                            _current        = this->end();
+                            other_._current = other_.end();
+                            other_._reshaped();
+                          }
+                          other_._resetCB.invoke({ &other_ }) ;
+                        }
                        ~oMap() 
                         {}
+  // copies the entries in; resetCB fires once instead of per element
   oMap                &operator=( const oMap &rhs_ ) 
                         { oMap &other = const_cast<oMap&>(rhs_);
+                          if( &rhs_ == this )
+                          {
+                            return( *this );
+                          }
+                          {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc1( other._gate ) ;
-                          lock_guard<LockFreeMutex>  sc2( _gate ) ;
+                            bool               lo = std::less<const oMap *>()( &other, this ) ;
+                            lock_guard<_Gate>  sc1( lo ? other._gate : _gate ) ;
+                            lock_guard<_Gate>  sc2( lo ? _gate : other._gate ) ;
 #endif
-                          clear();
-                          typename std::<Key,Value>::const_iterator  iter ;
-                          for (iter = rhs_.begin(); iter != rhs_.end(); iter++)
-                            std::map<Key,Value>::insert( std::pair<Key, Value>( (*iter).first, (*iter).second )) ;
+                            _Parent::clear();
+                            typename _Parent::const_iterator  iter ;
+                            for (iter = rhs_.begin(); iter != rhs_.end(); iter++)
+                              _Parent::insert( std::pair<Key, Value>( (*iter).first, (*iter).second )) ;
+                            _current = this->end();
+                            _reshaped();
+                          }
+                          _resetCB.invoke({ this }) ;
                           return( *this );
                         }
 
-  LockFreeMutex          &gate() { return( _gate ); }
+  // swaps the nodes in; both sides fire resetCB once instead of per element
+  oMap                &operator=( oMap &&other ) 
+                        {
+                          if( &other == this )
+                          {
+                            return( *this );
+                          }
+                          {
+#ifdef BOOST_HAS_THREADS
+                            // in address order, so a = b racing b = a cannot deadlock
+                            bool               lo = std::less<const oMap *>()( &other, this ) ;
+                            lock_guard<_Gate>  sc1( lo ? other._gate : _gate ) ;
+                            lock_guard<_Gate>  sc2( lo ? _gate : other._gate ) ;
+#endif
+                            _Parent::swap( other );
+                            other._Parent::clear();
+                            _current       = this->end();
+                            other._current = other.end();
+                            _reshaped();
+                            other._reshaped();
+                          }
+                          _resetCB.invoke({ this }) ;
+                          other._resetCB.invoke({ &other }) ;
+                          return( *this );
+                        }
+
+  _Gate                  &gate() { return( _gate ); }
   Subject                &preEraseCB() { return( _preEraseCB ); }
   Subject                &postInsertCB() { return( _postInsertCB ); }
+  Subject                &updateCB() { return( _updateCB ); }
+  Subject                &resetCB() { return( _resetCB ); }
+  uint64_t               version() const { return( _version.load( std::memory_order_acquire ) ); }
+  const std::atomic<uint64_t>  &version_counter() const { return( _version ); }
+
+  // subjects scoped to one key, or to the keys in [lo, hi]: notified with
+  // { iter, ChangeKind, this } when such a key is inserted, updated in place
+  // or (before) erased.  reset() and assignment only fire resetCB
+  Subject                &watch( const Key &k )
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          return( _watch_index().key( k ) );
+                        }
+  Subject                &watch_range( const Key &lo, const Key &hi )
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          return( _watch_index().range( lo, hi ) );
+                        }
+  // drops the watch and deletes its observers
+  bool                  unwatch( const Key &k )
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          return( _watches && _watches->erase_key( k ) );
+                        }
+  bool                  unwatch_range( const Key &lo, const Key &hi )
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          return( _watches && _watches->erase_range( lo, hi ) );
+                        }
+
+  // an immutable, consistent view for readers that must not hold the gate
+  // (reports, dashboards).  pages untouched since the previous snapshot are
+  // shared with it rather than copied; a version is freed with its last
+  // snapshot.  writes that bypass oMap (std::map::operator[], clear) are not
+  // tracked, as they are not notified
+  std::shared_ptr<const snapshot_type>  snapshot()
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          if( !_versions )
+                          {
+                            _versions.reset( new _Versions() );
+                          }
+                          return( _versions->snapshot( static_cast<const _Parent &>( *this )) );
+                        }
+
+  // replace the whole contents without per-element notifications (bulk load,
+  // snapshot restore).  input sorted by key builds in linear time
+  template <class _It>
+  void                  reset( _It f, _It l, bool notify = true )
+                        {
+                          {
+#ifdef BOOST_HAS_THREADS
+                            lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                            _Parent::clear();
+                            for( ; f != l; f++ )
+                              _Parent::emplace_hint( _Parent::end(), (*f).first, (*f).second );
+                            _current = this->end();
+                            _reshaped();
+                          }
+                          if( notify ) 
+                          {
+                            _resetCB.invoke({ this }) ;
+                          }
+                        }
   
+  // inserts obj, or assigns its value to the existing node in place (no
+  // erase/reinsert, no allocation) and fires updateCB with { iter, this }
   std::pair<gomap_iter, bool>  update(const gomap_pair &obj)
                         {
+                          return insert_or_assign( obj.first, obj.second ) ;
+                        }
+
+  template <class M>
+  std::pair<gomap_iter, bool>  insert_or_assign(const Key &k, M &&v)
+                        {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                          _current = find(obj.first);
-                          // if not already in the map, then only insert
-                          if( end() == _current ) 
+                          _current = this->lower_bound(k);
+                          if( (this->end() != _current) && !this->key_comp()(k, (*_current).first) )
                           {
-                            std::pair<gomap_iter, bool> insert_result = std::map<Key,Value>::insert(obj);
-                            _current = insert_result.first;
-                            _postInsertCB.invoke({ _current, this }) ;
-                            return( insert_result );
+                            (*_current).second = std::forward<M>(v);
+                            _updateCB.invoke({ _current, this }) ;
+                            _changed( _current, CHANGE_UPDATE ) ;
+                            return( std::pair<gomap_iter, bool>( _current, false ) );
                           }
-                          // erase current iter in preparation for insert.
-                          _preEraseCB.invoke({ _current, this });
-                          std::map<Key,Value>::erase(_current);
-                          std::pair<gomap_iter, bool> insert_result = std::map<Key,Value>::insert(obj);
-                          _current = insert_result.first;
+                          _current = _Parent::emplace_hint(_current, k, std::forward<M>(v));
                           _postInsertCB.invoke({ _current, this }) ;
+                          _changed( _current, CHANGE_INSERT ) ;
+                          return( std::pair<gomap_iter, bool>( _current, true ) );
+                        }
+
+  // constructs the value only if k is absent; an existing entry is left alone
+  template <class K, class... Args>
+  std::pair<gomap_iter, bool>  try_emplace(K &&k, Args&&... args)
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          std::pair<gomap_iter, bool> insert_result = _Parent::try_emplace(std::forward<K>(k), std::forward<Args>(args)...);
+                          _current = insert_result.first;
+                          if( insert_result.second ) 
+                          {
+                            _postInsertCB.invoke({ _current, this }) ;
+                            _changed( _current, CHANGE_INSERT ) ;
+                          }
+                          return insert_result ;
+                        }
+
+  // node handles: moving an entry between maps (or re-keying it) without
+  // freeing and reallocating its node.  extract fires preEraseCB, the
+  // node insert fires postInsertCB
+  node_type             extract(gomap_iter it)
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          _current = it;
+                          _preEraseCB.invoke({ _current, this }) ;
+                          _changed( _current, CHANGE_ERASE ) ;
+                          return( _Parent::extract(it) );
+                        }
+  node_type             extract(const Key &key)
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          _current = this->find(key);
+                          if( this->end() == _current )
+                          { 
+                            return( node_type() ); 
+                          }
+                          _preEraseCB.invoke({ _current, this }) ;
+                          _changed( _current, CHANGE_ERASE ) ;
+                          return( _Parent::extract(_current) );
+                        }
+  typename _Parent::insert_return_type  insert(node_type &&nh)
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          typename _Parent::insert_return_type insert_result = _Parent::insert(std::move(nh));
+                          _current = insert_result.position;
+                          if( insert_result.inserted ) 
+                          {
+                            _postInsertCB.invoke({ _current, this }) ;
+                            _changed( _current, CHANGE_INSERT ) ;
+                          }
                           return insert_result ;
                         }
 
@@ -84,17 +330,43 @@ class oMap : public std::map< Key, Value, _Pr >
                         {
                           return insert( gomap_pair( k, v ) ) ;
                         }
+  std::pair<gomap_iter, bool>  insert(const Key &k, Value &&v )
+                        {
+                          return emplace( k, std::move( v ) ) ;
+                        }
   
   std::pair<gomap_iter, bool>  insert(const gomap_pair& obj)
                         {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                          std::pair<gomap_iter, bool> insert_result = _Parent::insert(obj);
+                          _current = insert_result.first;
+                          if( insert_result.second ) 
+                          {
+                            _postInsertCB.invoke({ _current, this }) ;
+                            _changed( _current, CHANGE_INSERT ) ;
+                          }
+                          return insert_result ;
+                        }
+
+  std::pair<gomap_iter, bool>  insert(gomap_pair&& obj)
+                        {
+                          return emplace( std::move( obj ) ) ;
+                        }
+
+  template <class... Args>
+  std::pair<gomap_iter, bool>  emplace(Args&&... args)
+                        {
+#ifdef BOOST_HAS_THREADS
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                          std::pair<gomap_iter, bool> insert_result = std::map<Key,Value>::insert(obj);
+                          std::pair<gomap_iter, bool> insert_result = _Parent::emplace(std::forward<Args>(args)...);
                           _current = insert_result.first;
                           if( insert_result.second ) 
                           {
                             _postInsertCB.invoke({ _current, this }) ;
+                            _changed( _current, CHANGE_INSERT ) ;
                           }
                           return insert_result ;
                         }
@@ -102,13 +374,14 @@ class oMap : public std::map< Key, Value, _Pr >
   std::pair<gomap_iter, bool>  insert( gomap_iter pos, const gomap_pair& obj)
                         {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                          std::pair<gomap_iter, bool> insert_result = std::map<Key,Value>::insert(pos,obj);
+                          std::pair<gomap_iter, bool> insert_result = _Parent::insert(pos,obj);
                           _current = insert_result.first;
                           if( insert_result.second ) 
                           {
                           _postInsertCB.invoke({ _current, this }) ;
+                          _changed( _current, CHANGE_INSERT ) ;
                           } 
                           return insert_result ;
                         }
@@ -116,42 +389,47 @@ class oMap : public std::map< Key, Value, _Pr >
   size_t                erase(const Key & key) 
                         {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                          _current = find(key);
-                          if( end() == _current )
+                          _current = this->find(key);
+                          if( this->end() == _current )
                           { 
                             return( 0 ); 
                           }
                           _preEraseCB.invoke({ _current, this }) ;
-                          std::map<Key,Value>::erase(_current);
+                          _changed( _current, CHANGE_ERASE ) ;
+                          _Parent::erase(_current);
                           return( 1 );
                         }
 
   void                  erase(gomap_iter it)
                         {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                          if( end() == it )
+                          if( this->end() == it )
                           { 
                             return; 
                           }
                           _current = it; // con
                           _preEraseCB.invoke({ _current, this }) ;
-                          std::map<Key,Value>::erase(it); 
+                          _changed( _current, CHANGE_ERASE ) ;
+                          _Parent::erase(it); 
                         }
 
+  // notifies every element first, then unlinks the whole range in one call
   void                  erase(gomap_iter f, gomap_iter l)
                         {
 #ifdef BOOST_HAS_THREADS
-                          lock_guard<LockFreeMutex>  sc( _gate ) ;
+                          lock_guard<_Gate>  sc( _gate ) ;
 #endif
                           for( _current = f; _current != l; _current++ )
                           {
                             _preEraseCB.invoke({ _current, this }) ;
-                            std::map<Key,Value>::erase(_current); 
+                            _changed( _current, CHANGE_ERASE ) ;
                           }
+                          _Parent::erase(f, l); 
+                          _current = l;
                         }
 } ; // template oMap
 
@@ -0,0 +1,364 @@
+/*!
+  @file       omvector.hpp
+  @brief      oMappedVector template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Observable vector whose elements live in a memory-mapped file.
+
+  file layout (native endian):
+    MappedVectorHeader                  (64 bytes)
+    value[capacity]                     the first count are live
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/observe/subject.hpp>
+
+namespace boost { namespace observables {
+
+struct MappedVectorHeader
+{
+  uint32_t                 magic ;         // 'OBSM'
+  uint32_t                 version ;
+  uint32_t                 value_size ;
+  uint32_t                 reserved0 ;
+  uint64_t                 count ;         // live elements
+  uint64_t                 capacity ;      // elements the file has room for
+  uint64_t                 reserved[4] ;
+} ; // struct MappedVectorHeader
+
+enum { MAPPED_VECTOR_MAGIC = 0x4d53424f, MAPPED_VECTOR_VERSION = 1 } ;
+
+/*!
+  @class oMappedVector
+
+  <b>Description:</b>
+  same postInsertCB / preEraseCB / resetCB contract as oVector, but the
+  elements are the file: an append writes straight into the mapping and a
+  reopen maps the existing file back in without reading or copying it.  the
+  file grows by doubling, so appends stay amortized O(1).
+
+  <b>Notes:</b>
+  T must be trivially copyable.  iterators are plain pointers into the mapping;
+  growing the file remaps it, so (as with std::vector) any append may
+  invalidate them.  observers receive { iterator, this } as they do from
+  oVector.  advise() passes access-pattern hints through to madvise.
+*/
+template<class _Value, class _Gate = LockFreeMutex >
+class oMappedVector
+{
+  public:
+    typedef _Value              value_type;
+    typedef _Value             *iterator;
+    typedef const _Value       *const_iterator;
+    typedef size_t              size_type;
+    typedef basic_subject< _Gate >  Subject;
+
+    enum Access { ACCESS_NORMAL, ACCESS_SEQUENTIAL, ACCESS_RANDOM, ACCESS_WILLNEED, ACCESS_DONTNEED } ;
+
+    class BadFile { public: BadFile() {} } ;
+
+  private:
+    typedef oMappedVector< _Value, _Gate >  _TGOMVector;
+
+    static_assert( std::is_trivially_copyable<_Value>::value, "oMappedVector values must be trivially copyable" ) ;
+    static_assert( alignof(_Value) <= sizeof(MappedVectorHeader), "oMappedVector values are over-aligned" ) ;
+
+#ifdef BOOST_HAS_THREADS
+    _Gate                                _gate;
+#endif
+    std::string                          _path;
+    boost::interprocess::file_mapping    _file;
+    boost::interprocess::mapped_region   _region;
+    MappedVectorHeader                  *_hdr;
+    _Value                              *_data;
+    Access                               _access;
+    iterator                             _current;
+    Subject                              _postInsertCB;
+    Subject                              _preEraseCB;
+    Subject                              _resetCB;
+
+    static uint64_t      _bytes( uint64_t n ) { return( sizeof(MappedVectorHeader) + n * sizeof(_Value) ); }
+
+    // maps the whole file; the previous mapping stays if this throws
+    void                 _map()
+                         {
+                           boost::interprocess::mapped_region  r( _file, boost::interprocess::read_write );
+                           _region.swap( r );
+                           _hdr    = (MappedVectorHeader *)_region.get_address();
+                           _data   = (_Value *)((char *)_hdr + sizeof(MappedVectorHeader));
+                           _advise( _access );
+                         }
+    void                 _advise( Access a )
+                         {
+                           typedef boost::interprocess::mapped_region  _R;
+                           switch( a )
+                           {
+                             case ACCESS_SEQUENTIAL : _region.advise( _R::advice_sequential ); break;
+                             case ACCESS_RANDOM     : _region.advise( _R::advice_random ); break;
+                             case ACCESS_WILLNEED   : _region.advise( _R::advice_willneed ); break;
+                             case ACCESS_DONTNEED   : _region.advise( _R::advice_dontneed ); break;
+                             default                : _region.advise( _R::advice_normal ); break;
+                           }
+                         }
+    // extends the file to hold n elements and maps it again; on failure the
+    // old mapping is kept.  caller holds the gate
+    void                 _grow( uint64_t n )
+                         {
+                           uint64_t  count = _hdr->count;
+                           {
+                             std::filebuf  fb ;
+                             if( !fb.open( _path.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary ) )
+                               throw BadFile();
+                             fb.pubseekoff( _bytes( n ) - 1, std::ios_base::beg );
+                             fb.sputc( 0 );
+                           }
+                           _map();
+                           _hdr->count    = count;
+                           _hdr->capacity = n;
+                         }
+    void                 _reserve( uint64_t n )
+                         {
+                           if( n <= _hdr->capacity )
+                           {
+                             return;
+                           }
+                           uint64_t  cap = (_hdr->capacity < 1024) ? 1024 : _hdr->capacity;
+                           while( cap < n )
+                           {
+                             cap *= 2;
+                           }
+                           _grow( cap );
+                         }
+
+  public:
+                         // opens path if it holds a vector of this element size, creates it otherwise
+                         oMappedVector( const char *path, size_type initial_capacity = 1024, Access a = ACCESS_SEQUENTIAL )
+                         : _path( path ), _hdr( nullptr ), _data( nullptr ), _access( a ), _current( nullptr )
+                         , _postInsertCB( this ), _preEraseCB( this ), _resetCB( this )
+                         {
+                           bool  fresh = false;
+                           {
+                             std::filebuf  fb ;
+                             if( !fb.open( path, std::ios_base::in | std::ios_base::out | std::ios_base::binary ) )
+                             {
+                               if( !fb.open( path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary ) )
+                                 throw BadFile();
+                               if( initial_capacity == 0 )
+                                 initial_capacity = 1;
+                               fb.pubseekoff( _bytes( initial_capacity ) - 1, std::ios_base::beg );
+                               fb.sputc( 0 );
+                               fresh = true;
+                             }
+                           }
+                           _file = boost::interprocess::file_mapping( path, boost::interprocess::read_write );
+                           _map();
+                           if( fresh )
+                           {
+                             memset( _hdr, 0, sizeof(MappedVectorHeader) );
+                             _hdr->magic      = MAPPED_VECTOR_MAGIC;
+                             _hdr->version    = MAPPED_VECTOR_VERSION;
+                             _hdr->value_size = (uint32_t)sizeof(_Value);
+                             _hdr->capacity   = initial_capacity;
+                           }
+                           else if( (_region.get_size() < sizeof(MappedVectorHeader))
+                                 || (_hdr->magic != MAPPED_VECTOR_MAGIC) || (_hdr->version != MAPPED_VECTOR_VERSION)
+                                 || (_hdr->value_size != sizeof(_Value)) || (_hdr->count > _hdr->capacity)
+                                 || (_region.get_size() < _bytes( _hdr->capacity )) )
+                           {
+                             throw BadFile();
+                           }
+                         }
+                         oMappedVector( const _TGOMVector & ) = delete;
+    _TGOMVector         &operator=( const _TGOMVector & ) = delete;
+    virtual             ~oMappedVector()
+                         {
+                           flush( false );
+                         }
+
+    void                 reserve(size_type _N)
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           _reserve( _N );
+                         }
+    // grows without notifications, like oVector::resize
+    void                 resize(size_type _N, _Value x = _Value() )
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           _reserve( _N );
+                           for( uint64_t i = _hdr->count; i < _N; i++ )
+                           {
+                             _data[i] = x;
+                           }
+                           _hdr->count = _N;
+                         }
+    void                 push_back(const _Value& _X)
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           _Value  x = _X;              // _X may live in the mapping
+                           if( _hdr->count == _hdr->capacity )
+                           {
+                             _reserve( _hdr->count + 1 );
+                           }
+                           _current  = _data + _hdr->count;
+                           *_current = x;
+                           _hdr->count++;
+                           _postInsertCB.invoke({ _current, this });
+                         }
+    void                 pop_back()
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           if( _hdr->count < 1 )
+                           {
+                             return;
+                           }
+                           _current = _data + _hdr->count - 1;
+                           _preEraseCB.invoke({ _current, this });
+                           _hdr->count--;
+                         }
+    iterator             insert(iterator _P, const _Value& _X)
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           size_t  ndx = _P - _data;
+                           _Value  x   = _X;            // _X may live in the mapping
+                           if( _hdr->count == _hdr->capacity )
+                           {
+                             _reserve( _hdr->count + 1 );
+                           }
+                           memmove( _data + ndx + 1, _data + ndx, (_hdr->count - ndx) * sizeof(_Value) );
+                           _current  = _data + ndx;
+                           *_current = x;
+                           _hdr->count++;
+                           _postInsertCB.invoke({ _current, this });
+                           return( _current );
+                         }
+    iterator             erase(iterator _P)
+                         {
+                           return( erase( _P, _P + 1 ) );
+                         }
+    iterator             erase(iterator _F, iterator _L)
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           if( _L > end() )
+                           {
+                             _L = end();
+                           }
+                           if( _F >= _L )
+                           {
+                             return( _L );
+                           }
+                           for( _current = _F; _current != _L; _current++ )
+                           {
+                             _preEraseCB.invoke({ _current, this });
+                           }
+                           memmove( _F, _L, (end() - _L) * sizeof(_Value) );
+                           _hdr->count -= (_L - _F);
+                           return( _F );
+                         }
+    // replace the whole contents without per-element notifications; fires
+    // resetCB once when notify is set
+    template <class _It>
+    void                 reset( _It _F, _It _L, bool notify = true )
+                         {
+                           {
+#ifdef BOOST_HAS_THREADS
+                             lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                             _hdr->count = 0;
+                             for( ; _F != _L; _F++ )
+                             {
+                               if( _hdr->count == _hdr->capacity )
+                               {
+                                 _reserve( _hdr->count + 1 );
+                               }
+                               _data[ _hdr->count++ ] = *_F;
+                             }
+                             _current = end();
+                           }
+                           if( notify )
+                           {
+                             _resetCB.invoke({ this });
+                           }
+                         }
+    void                 clear()
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           for( _current = begin(); _current != end(); _current++ )
+                           {
+                             _preEraseCB.invoke({ _current, this });
+                           }
+                           _hdr->count = 0;
+                         }
+
+    // writes dirty pages back to the file; async returns before the I/O completes
+    bool                 flush( bool async = true )
+                         {
+                           return( _region.flush( 0, _bytes( _hdr->count ), async ) );
+                         }
+    // madvise hint for the whole mapping; kept across growth
+    void                 advise( Access a )
+                         {
+#ifdef BOOST_HAS_THREADS
+                           lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                           _access = a;
+                           _advise( a );
+                         }
+
+    // access methods
+    iterator             begin() { return( _data ); }
+    iterator             end() { return( _data + _hdr->count ); }
+    const_iterator       begin() const { return( _data ); }
+    const_iterator       end() const { return( _data + _hdr->count ); }
+    _Value              *data() { return( _data ); }
+    size_type            size() const { return( (size_type)_hdr->count ); }
+    size_type            capacity() const { return( (size_type)_hdr->capacity ); }
+    bool                 empty() const { return( _hdr->count == 0 ); }
+    _Value              &operator[]( size_type n ) { return( _data[n] ); }
+    const _Value        &operator[]( size_type n ) const { return( _data[n] ); }
+    _Value              &at( size_type n )
+                         {
+                           if( n >= _hdr->count )
+                             throw std::out_of_range( "oMappedVector::at" );
+                           return( _data[n] );
+                         }
+    _Value              &front() { return( _data[0] ); }
+    _Value              &back() { return( _data[ _hdr->count - 1 ] ); }
+    const std::string   &path() const { return( _path ); }
+#ifdef BOOST_HAS_THREADS
+    _Gate               &gate() { return( _gate ); }
+#endif
+    Subject             &postInsertCB() { return( _postInsertCB ); }
+    Subject             &preEraseCB() { return( _preEraseCB ); }
+    Subject             &resetCB() { return( _resetCB ); }
+    iterator            &current() { return( _current ); }
+} ; // template oMappedVector
+
+}} ; // namespace
@@ -0,0 +1,258 @@
+/*!
+  @file       otimeseries.hpp
+  @brief      oTimeSeries template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "boost/observe/numerics.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class oTimeSeries< T >
+
+  <b>Description:</b>
+  rolling window over a stream of values, e.g. the last 500 ticks of a price
+  or the last 5 minutes of trades.  a sample leaves the window when the count
+  limit is reached or once it is window_ns old (0 = no time limit).
+  every push updates, in O(1) amortized and without allocating:
+    count      samples in the window
+    mean       weighted mean; with weight = traded quantity this is the VWAP
+    variance   weighted population variance (sliding Welford, no cancellation)
+    min / max  monotonic deques over the ring
+    ewma       exponentially weighted moving average, per sample
+    last       the latest value
+  each is a Numeric< double, _Gate >, so it can be watched like any other value.
+
+  <b>Notes:</b>
+  attach( numeric ) feeds the series from a Numeric's valueCB.  the link is
+  cut when the series is destroyed; the tap observer then expires on the
+  source's next change.  statistics are published after the series' gate is
+  released, so their watchers may read the series freely.
+*/
+template <class T, class _Gate = LockFreeMutex>
+class oTimeSeries
+{
+  private   :
+    struct _Sample
+    {
+      T                              value ;
+      double                         weight ;
+      uint64_t                       ts ;
+    } ;
+
+    // fixed-capacity deque of sequence numbers: min/max candidates
+    struct _Mono
+    {
+      std::vector<uint64_t>          seq ;
+      size_t                         head ;
+      size_t                         n ;
+
+      void                           init( size_t cap ) { seq.assign( cap, 0 ) ; head = n = 0 ; }
+      uint64_t                       front() const { return seq[ head ] ; }
+      uint64_t                       back() const { return seq[ (head + n - 1) % seq.size() ] ; }
+      void                           pop_front() { head = (head + 1) % seq.size() ; n-- ; }
+      void                           pop_back() { n-- ; }
+      void                           push_back( uint64_t s ) { seq[ (head + n) % seq.size() ] = s ; n++ ; }
+    } ;
+
+    // shared with the taps installed by attach(), so they can outlive us
+    struct _Link
+    {
+      LockFreeMutex                  lock ;
+      oTimeSeries                   *series ;
+    } ;
+
+    class _Tap : public boost::observers::Observer
+    {
+      protected :
+        std::shared_ptr<_Link>       _link ;
+
+      public    :
+                                     _Tap( const std::shared_ptr<_Link> &l ) : _link( l ) {}
+
+        virtual int                  invoke() { return 0 ; }
+        virtual int                  invoke( const std::vector<boost::any> &args )
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _link->lock ) ;
+                                       if (_link->series == nullptr)
+                                       {
+                                         expire() ;
+                                         return 0 ;
+                                       }
+                                       _link->series->push( boost::any_cast<T>( args[0] )) ;
+                                       return 0 ;
+                                     }
+        virtual const char          *kind() const { return "oTimeSeries" ; }
+    } ; // class _Tap
+
+#ifdef BOOST_HAS_THREADS
+    _Gate                            _gate ;
+#endif
+    std::vector<_Sample>             _ring ;
+    uint64_t                         _first ;     // seq of the oldest sample in the window
+    uint64_t                         _next ;      // seq of the next sample
+    uint64_t                         _window ;    // ns; 0 = count only
+    double                           _alpha ;
+    double                           _w ;         // Welford state, weighted
+    double                           _mu ;
+    double                           _m2 ;
+    double                           _ew ;
+    _Mono                            _lo ;
+    _Mono                            _hi ;
+    std::shared_ptr<_Link>           _link ;
+
+    Numeric<double,_Gate>            _count ;
+    Numeric<double,_Gate>            _mean ;
+    Numeric<double,_Gate>            _variance ;
+    Numeric<double,_Gate>            _min ;
+    Numeric<double,_Gate>            _max ;
+    Numeric<double,_Gate>            _ewma ;
+    Numeric<double,_Gate>            _last ;
+
+    _Sample                         &_at( uint64_t s ) { return _ring[ s % _ring.size() ] ; }
+    void                             _evict()
+                                     {
+                                       _Sample  &o = _at( _first ) ;
+                                       _w -= o.weight ;
+                                       if (_w <= 0)
+                                       {
+                                         _w = _mu = _m2 = 0 ;
+                                       }
+                                       else
+                                       {
+                                         double  d = (double)o.value - _mu ;
+                                         _mu -= o.weight * d / _w ;
+                                         _m2 -= o.weight * d * ((double)o.value - _mu) ;
+                                         if (_m2 < 0)  _m2 = 0 ;
+                                       }
+                                       if ((_lo.n != 0) && (_lo.front() == _first))  _lo.pop_front() ;
+                                       if ((_hi.n != 0) && (_hi.front() == _first))  _hi.pop_front() ;
+                                       _first++ ;
+                                     }
+
+  public    :
+                                     oTimeSeries( size_t max_count, uint64_t window_ns = 0, double ewma_alpha = 0.1 )
+                                     : _ring( (max_count == 0) ? 1 : max_count ), _first( 0 ), _next( 0 ), _window( window_ns )
+                                     , _alpha( ewma_alpha ), _w( 0 ), _mu( 0 ), _m2( 0 ), _ew( 0 ), _link( std::make_shared<_Link>() )
+                                     {
+                                       _lo.init( _ring.size() ) ;
+                                       _hi.init( _ring.size() ) ;
+                                       _link->series = this ;
+                                     }
+                                     oTimeSeries( const oTimeSeries & ) = delete ;
+    oTimeSeries                     &operator=( const oTimeSeries & ) = delete ;
+                                    ~oTimeSeries()
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _link->lock ) ;
+                                       _link->series = nullptr ;
+                                     }
+
+    static uint64_t                  now()
+                                     {
+                                       return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                std::chrono::steady_clock::now().time_since_epoch() ).count() ;
+                                     }
+
+    // adds a sample; weight is e.g. the traded quantity for a VWAP
+    void                             push( const T &x, double weight = 1.0, uint64_t ts = 0 )
+                                     {
+                                       double  n, mean, var, lo, hi, ew ;
+                                       {
+#ifdef BOOST_HAS_THREADS
+                                         lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                         if (_window != 0 && ts == 0)
+                                           ts = now() ;
+                                         if (_next - _first == _ring.size())
+                                           _evict() ;
+                                         if (_window != 0)
+                                         {
+                                           while ((_first != _next) && (ts - _at( _first ).ts >= _window))
+                                             _evict() ;
+                                         }
+
+                                         uint64_t  s = _next++ ;
+                                         _at( s ) = _Sample{ x, weight, ts } ;
+
+                                         _w += weight ;
+                                         if (_w > 0)      // zero weight so far: nothing to average yet
+                                         {
+                                           double  d = (double)x - _mu ;
+                                           _mu += weight * d / _w ;
+                                           _m2 += weight * d * ((double)x - _mu) ;
+                                         }
+                                         else
+                                           _w = _mu = _m2 = 0 ;
+                                         _ew  = (s == 0) ? (double)x : _alpha * (double)x + (1.0 - _alpha) * _ew ;
+
+                                         while ((_lo.n != 0) && !(_at( _lo.back() ).value < x))  _lo.pop_back() ;
+                                         while ((_hi.n != 0) && !(x < _at( _hi.back() ).value))  _hi.pop_back() ;
+                                         _lo.push_back( s ) ;
+                                         _hi.push_back( s ) ;
+
+                                         n    = (double)(_next - _first) ;
+                                         mean = _mu ;
+                                         var  = (_w > 0) ? _m2 / _w : 0 ;
+                                         lo   = (double)_at( _lo.front() ).value ;
+                                         hi   = (double)_at( _hi.front() ).value ;
+                                         ew   = _ew ;
+                                       }
+                                       _count    = n ;
+                                       _mean     = mean ;
+                                       _variance = var ;
+                                       _min      = lo ;
+                                       _max      = hi ;
+                                       _ewma     = ew ;
+                                       _last     = (double)x ;
+                                     }
+
+    // feeds the series from src's valueCB, one sample of weight 1 per change
+    template <class _SrcGate>
+    boost::observers::Observer      *attach( Numeric<T,_SrcGate> &src ) { return src.valueCB().install( new _Tap( _link )) ; }
+
+    // the i-th sample in the window, oldest first
+    T                                at( size_t i )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       return _at( _first + i ).value ;
+                                     }
+    size_t                           size()
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       return (size_t)(_next - _first) ;
+                                     }
+
+    // access methods
+    size_t                           capacity() const { return _ring.size() ; }
+    uint64_t                         window() const { return _window ; }
+    Numeric<double,_Gate>           &count() { return _count ; }
+    Numeric<double,_Gate>           &mean() { return _mean ; }
+    Numeric<double,_Gate>           &variance() { return _variance ; }
+    Numeric<double,_Gate>           &min() { return _min ; }
+    Numeric<double,_Gate>           &max() { return _max ; }
+    Numeric<double,_Gate>           &ewma() { return _ewma ; }
+    Numeric<double,_Gate>           &last() { return _last ; }
+    double                           stddev() { return sqrt( (double)_variance ) ; }
+#ifdef BOOST_HAS_THREADS
+    _Gate                           &gate() { return _gate ; }
+#endif
+} ; // class oTimeSeries
+
+}} ; // namespace
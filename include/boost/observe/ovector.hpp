@@ -12,6 +12,11 @@
 #pragma once
 
 #include <boost/observe/subject.hpp>
+#include <boost/observe/watch.hpp>
+#include <boost/observe/mvcc.hpp>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace boost { namespace observables {
@@ -22,6 +27,16 @@ class oVector : public std::vector< _Value >
   private:
     typedef std::vector< _Value >     _Parent;
     typedef oVector< _Value, _Gate >  _TGOVector;
+    typedef WatchIndex< size_t, std::less<size_t>, _Gate >  _Watches;
+    typedef VectorVersions< _Value >  _Versions;
+
+  public:
+    typedef typename _Parent::iterator   iterator;
+    typedef typename _Parent::size_type  size_type;
+    typedef basic_subject< _Gate >       Subject;
+    typedef VectorSnapshot< _Value >     snapshot_type;
+
+  private:
 
 #ifdef BOOST_HAS_THREADS
     _Gate          _gate;
@@ -29,42 +44,135 @@ class oVector : public std::vector< _Value >
     iterator       _current;
     Subject        _postInsertCB;
     Subject        _preEraseCB;
+    Subject        _resetCB;         // contents replaced in bulk; no per-element notifications
+    std::unique_ptr<_Watches>  _watches;  // index and index-range subjects; null until the first watch
+    std::unique_ptr<_Versions> _versions; // pages written since the last snapshot; null until the first snapshot
+    std::atomic<uint64_t>      _version;  // bumped by every tracked change; see ChangeCursor
+
+    // tells the watches scoped to its index; lock held
+    void           _changed( iterator it, ChangeKind kind )
+                   {
+                     _touched( (size_t)(it - this->begin()) );
+                     _notify( it, kind );
+                   }
+    void           _notify( iterator it, ChangeKind kind )
+                   {
+                     if( _watches )
+                     {
+                       _watches->for_each( (size_t)(it - this->begin()), [&]( Subject &s ){ s.invoke({ it, kind, this }); } );
+                     }
+                   }
+    // everything from ndx on may have moved: once per operation, not per
+    // element, since each call walks the pages after ndx
+    void           _touched( size_t ndx )
+                   {
+                     _bump();
+                     if( _versions )
+                     {
+                       _versions->dirty_from( ndx );
+                     }
+                   }
+    _Watches      &_watch_index()
+                   {
+                     if( !_watches )
+                     {
+                       _watches.reset( new _Watches( this ) );
+                     }
+                     return( *_watches );
+                   }
+    void           _bump()
+                   {
+                     _version.fetch_add( 1, std::memory_order_release );
+                   }
+    void           _reshaped()
+                   {
+                     _bump();
+                     if( _versions )
+                     {
+                       _versions->invalidate();
+                     }
+                   }
 
   public:
                    oVector() 
-                   : _postInsertCB( this ), _preEraseCB( this )
+                   : _postInsertCB( this ), _preEraseCB( this ), _resetCB( this ), _version( 0 )
                    {}
                    oVector(size_type _N ) 
-                   : _Parent( _N ), _postInsertCB( this ), _preEraseCB( this )
+                   : _Parent( _N ), _postInsertCB( this ), _preEraseCB( this ), _resetCB( this ), _version( 0 )
                    {}
                    oVector( const _TGOVector& _X) 
-                   : _postInsertCB( this ), _preEraseCB( this )
+                   : _postInsertCB( this ), _preEraseCB( this ), _resetCB( this ), _version( 0 )
                    {
                      _TGOVector &other = const_cast<_TGOVector &>(_X);
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( other._gate ) ;
 #endif
-                     insert( begin(), other.begin(), other.end() );
+                     insert( this->begin(), other.begin(), other.end() );
+                   }
+                   // takes other's storage as is: no per-element notifications.  observers
+                   // stay with the object they were installed on
+                   oVector( _TGOVector&& _X) 
+                   : _postInsertCB( this ), _preEraseCB( this ), _resetCB( this ), _version( 0 )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _X._gate ) ;
+#endif
+                     _Parent::swap( _X );
+                     _current = this->end();
+                     _X._reshaped();
                    }
     virtual       ~oVector() {}
 
     _TGOVector    &operator=( const _TGOVector &cother_ ) 
                    {
                      _TGOVector &other = const_cast<_TGOVector &>(cother_);
+                     if( &other == this )
+                     {
+                       return( *this );
+                     }
 #ifdef BOOST_HAS_THREADS
-                     lock_guard<_Gate>  sc1( other._gate ) ;
-                     lock_guard<_Gate>  sc2( _gate ) ;
+                     bool               lo = std::less<const _TGOVector *>()( &other, this ) ;
+                     lock_guard<_Gate>  sc1( lo ? other._gate : _gate ) ;
+                     lock_guard<_Gate>  sc2( lo ? _gate : other._gate ) ;
 #endif
-                     for( _current = begin(); _current != end(); _current++ ) 
+                     for( _current = this->begin(); _current != this->end(); _current++ ) 
                      {
                        _preEraseCB.invoke({ _current, this });
+                       _notify( _current, CHANGE_ERASE );
                      }
                      _Parent::clear();
+                     _touched( 0 );
                      for( _current = other.begin(); _current != other.end(); _current++ ) 
                      {
                        _Parent::push_back( (*_current) );
                        _postInsertCB.invoke({ _current, this });
+                       _notify( this->end() - 1, CHANGE_INSERT );
+                     }
+                     return( *this );
+                   }
+    // swaps storage in; both sides fire resetCB once instead of per element
+    _TGOVector    &operator=( _TGOVector &&other ) 
+                   {
+                     if( &other == this )
+                     {
+                       return( *this );
                      }
+                     {
+#ifdef BOOST_HAS_THREADS
+                       // in address order, so a = b racing b = a cannot deadlock
+                       bool               lo = std::less<const _TGOVector *>()( &other, this ) ;
+                       lock_guard<_Gate>  sc1( lo ? other._gate : _gate ) ;
+                       lock_guard<_Gate>  sc2( lo ? _gate : other._gate ) ;
+#endif
+                       _Parent::swap( other );
+                       other._Parent::clear();
+                       _current       = this->end();
+                       other._current = other.end();
+                       _reshaped();
+                       other._reshaped();
+                     }
+                     _resetCB.invoke({ this });
+                     other._resetCB.invoke({ &other });
                      return( *this );
                    }
     void           reserve(size_type _N) 
@@ -74,12 +182,13 @@ class oVector : public std::vector< _Value >
 #endif
                      _Parent::reserve( _N );
                    }
-    void           resize(size_type _N, _Value x = T() )
+    void           resize(size_type _N, _Value x = _Value() )
                    {
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
                      _Parent::resize( _N, x );
+                     _reshaped();
                    }
     void           push_back(const _Value& _X)
                    {
@@ -87,20 +196,43 @@ class oVector : public std::vector< _Value >
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
                      _Parent::push_back( _X );
-                     _current = (end() - 1);    
+                     _current = (this->end() - 1);    
+                     _postInsertCB.invoke({ _current, this });
+                     _changed( _current, CHANGE_INSERT );
+                   }
+    void           push_back(_Value&& _X)
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     _Parent::push_back( std::move( _X ) );
+                     _current = (this->end() - 1);    
+                     _postInsertCB.invoke({ _current, this });
+                     _changed( _current, CHANGE_INSERT );
+                   }
+    template <class... _Args>
+    void           emplace_back(_Args&&... args)
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     _Parent::emplace_back( std::forward<_Args>( args )... );
+                     _current = (this->end() - 1);    
                      _postInsertCB.invoke({ _current, this });
+                     _changed( _current, CHANGE_INSERT );
                    }
     void           pop_back()
                    {
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                     if( size() < 1 ) 
+                     if( this->size() < 1 ) 
                      {
                        return;
                      }
-                     _current = (end()-1);
+                     _current = (this->end()-1);
                      _preEraseCB.invoke({ _current, this });
+                     _changed( _current, CHANGE_ERASE );
                      _Parent::pop_back();
                    }
     void           assign( iterator _F, iterator _L )
@@ -109,6 +241,7 @@ class oVector : public std::vector< _Value >
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
                      _Parent::assign( _F, _L );
+                     _reshaped();
                    }
     void           assign(size_type _N, const _Value& _X = _Value() )
                    {
@@ -116,6 +249,26 @@ class oVector : public std::vector< _Value >
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
                      _Parent::assign( _N, _X );
+                     _reshaped();
+                   }
+    iterator       insert(iterator _P, const _Value& _X)
+                   {
+                     return( emplace( _P, _X ) );
+                   }
+    iterator       insert(iterator _P, _Value&& _X)
+                   {
+                     return( emplace( _P, std::move( _X ) ) );
+                   }
+    template <class... _Args>
+    iterator       emplace(iterator _P, _Args&&... args)
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     _current = _Parent::emplace( _P, std::forward<_Args>( args )... );
+                     _postInsertCB.invoke({ _current, this });
+                     _changed( _current, CHANGE_INSERT );
+                     return( _current );
                    }
     iterator       insert(iterator _P, size_type n, const _Value& _X = _Value() )
                    {
@@ -123,9 +276,14 @@ class oVector : public std::vector< _Value >
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
                      _current = _Parent::insert( _P, n, _X );
-                     if( end() != _current ) 
+                     if( this->end() != _current ) 
                      {
                        _postInsertCB.invoke({ _current, this });
+                       _touched( (size_t)(_current - this->begin()) );
+                       for( size_type i = 0; i < n; i++ )
+                       {
+                         _notify( _current + i, CHANGE_INSERT );
+                       }
                      }
                      return( _current );
                    }
@@ -138,11 +296,12 @@ class oVector : public std::vector< _Value >
                      {
                        return;
                      }
-                     _current = _P;
                      for( iterator iter = _F; iter != _L; iter++ ) 
                      {
-                       insert( _P, (*iter) );
+                       _current = _Parent::insert( _P, (*iter) );
+                       _P = _current + 1;
                        _postInsertCB.invoke({ _current, this });
+                       _changed( _current, CHANGE_INSERT );
                      }
                    }
 
@@ -151,10 +310,11 @@ class oVector : public std::vector< _Value >
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                     if( end() != _P ) 
+                     if( this->end() != _P ) 
                      {
                        _current = _P;
                        _preEraseCB.invoke({ _current, this });
+                       _changed( _current, CHANGE_ERASE );
                      }
                      return( _Parent::erase( _P ) );
                    }
@@ -163,21 +323,79 @@ class oVector : public std::vector< _Value >
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
+                     if( _F == _L )
+                     {
+                       return( _L );
+                     }
                      for( _current = _F; _current != _L; _current++ ) 
                      {
                        _preEraseCB.invoke({ _current, this });
+                       _notify( _current, CHANGE_ERASE );
                      }
+                     _touched( (size_t)(_F - this->begin()) );
                      return( _Parent::erase( _F, _L ) );
                    }
+    // writes an element in place; unlike a write through operator[] it is
+    // seen by the next snapshot()
+    void           set( size_type ndx, const _Value& _X )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     (*this)[ ndx ] = _X;
+                     _bump();
+                     if( _versions )
+                     {
+                       _versions->dirty( ndx );
+                     }
+                   }
+    // an immutable, consistent view for readers that must not hold the gate.
+    // pages untouched since the previous snapshot are shared with it rather
+    // than copied; a version is freed with its last snapshot
+    std::shared_ptr<const snapshot_type>  snapshot()
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     if( !_versions )
+                     {
+                       _versions.reset( new _Versions() );
+                     }
+                     return( _versions->snapshot( static_cast<const _Parent &>( *this ) ) );
+                   }
+    // replace the whole contents without per-element notifications (bulk
+    // load, snapshot restore); fires resetCB once when notify is set
+    template <class _It>
+    void           reset( _It _F, _It _L, bool notify = true )
+                   {
+                     {
+#ifdef BOOST_HAS_THREADS
+                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                       _Parent::assign( _F, _L );
+                       _current = this->end();
+                       _reshaped();
+                     }
+                     if( notify ) 
+                     {
+                       _resetCB.invoke({ this });
+                     }
+                   }
     void           clear()
                    {
 #ifdef BOOST_HAS_THREADS
                      lock_guard<_Gate>  sc( _gate ) ;
 #endif
-                     for( _current = begin(); _current != end(); _current++ ) 
+                     if( this->empty() )
+                     {
+                       return;
+                     }
+                     for( _current = this->begin(); _current != this->end(); _current++ ) 
                      {
                        _preEraseCB.invoke({ _current, this });
+                       _notify( _current, CHANGE_ERASE );
                      }
+                     _touched( 0 );
                      _Parent::clear();
                    }
 
@@ -187,7 +405,44 @@ class oVector : public std::vector< _Value >
 #endif
     Subject       &postInsertCB() { return( _postInsertCB ); }
     Subject       &preEraseCB() { return( _preEraseCB ); }
+    Subject       &resetCB() { return( _resetCB ); }
     iterator      &current() { return( _current ); }
+    uint64_t       version() const { return( _version.load( std::memory_order_acquire ) ); }
+    const std::atomic<uint64_t>  &version_counter() const { return( _version ); }
+
+    // subjects scoped to one index, or to the indices in [lo, hi]: notified
+    // with { iter, ChangeKind, this } when an element is inserted at, or
+    // (before) erased from, such an index.  elements shifted along by an
+    // insert or erase elsewhere are not reported
+    Subject       &watch( size_type ndx )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     return( _watch_index().key( ndx ) );
+                   }
+    Subject       &watch_range( size_type lo, size_type hi )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     return( _watch_index().range( lo, hi ) );
+                   }
+    // drops the watch and deletes its observers
+    bool           unwatch( size_type ndx )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     return( _watches && _watches->erase_key( ndx ) );
+                   }
+    bool           unwatch_range( size_type lo, size_type hi )
+                   {
+#ifdef BOOST_HAS_THREADS
+                     lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                     return( _watches && _watches->erase_range( lo, hi ) );
+                   }
 } ; // template oVector
 
 }} ; // namespace
@@ -0,0 +1,179 @@
+/*!
+  @file       parking.hpp
+  @brief      ParkingLot class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Blocking waits on any address without a mutex or condition variable per
+  waitable object.  Waiters park on one of a fixed set of stripes chosen by
+  hashing the address; a stripe is a waiter count and a wake sequence, and
+  the thread sleeps on the sequence word itself:
+
+    linux     futex (FUTEX_WAIT_PRIVATE / FUTEX_WAKE_PRIVATE)
+    windows   WaitOnAddress / WakeByAddressAll
+    other     a condition variable shared by the whole lot
+*/
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include <atomic>
+#include <chrono>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#pragma comment( lib, "Synchronization.lib" )
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace boost { namespace observables {
+
+/*!
+  @class ParkingLot
+
+  <b>Description:</b>
+  park( addr, ready ) blocks until ready() holds; unpark_all( addr ) is
+  called after any write that might make it hold.  unpark_all is one load
+  of the stripe's waiter count while nobody waits there, and a wake
+  syscall only when someone does.
+
+  <b>Notes:</b>
+  the writer must store the value seq_cst before unpark_all, and ready()
+  must load it seq_cst: either the writer sees the waiter's count, or the
+  waiter sees the new value.  addresses sharing a stripe wake each other;
+  park re-checks ready() and sleeps again, so that costs a spurious wakeup
+  and nothing more.
+*/
+class ParkingLot
+{
+  public    :
+    enum { STRIPES = 64, SPINS = 100 } ;
+
+  private   :
+    struct alignas(64) _Stripe
+    {
+      std::atomic<uint32_t>          waiters ;
+      std::atomic<uint32_t>          seq ;
+    } ;
+
+    _Stripe                          _stripes[ STRIPES ] ;
+#if !defined(__linux__) && !defined(_WIN32)
+    std::mutex                       _mtx ;
+    std::condition_variable          _cv ;
+#endif
+
+                                     ParkingLot()
+                                     {
+                                       for (_Stripe &s : _stripes)
+                                       {
+                                         s.waiters.store( 0 ) ;
+                                         s.seq.store( 0 ) ;
+                                       }
+                                     }
+
+    _Stripe                         &_stripe( const void *addr )
+                                     {
+                                       uint64_t  a = (uint64_t)(uintptr_t)addr ;
+                                       a = (a ^ (a >> 17)) * 0x9E3779B97F4A7C15ull ;
+                                       return _stripes[ a >> 58 ] ;     // top 6 bits: STRIPES == 64
+                                     }
+    // sleeps while seq still reads expect, until woken or deadline
+    void                             _sleep( std::atomic<uint32_t> &seq, uint32_t expect, std::chrono::steady_clock::time_point deadline )
+                                     {
+                                       bool  forever = (deadline == std::chrono::steady_clock::time_point::max()) ;
+                                       auto  left    = deadline - std::chrono::steady_clock::now() ;
+#if defined(__linux__)
+                                       struct timespec  ts ;
+                                       if (!forever)
+                                       {
+                                         long long  ns = std::chrono::duration_cast<std::chrono::nanoseconds>( left ).count() ;
+                                         ts.tv_sec  = (time_t)(ns / 1000000000) ;
+                                         ts.tv_nsec = (long)(ns % 1000000000) ;
+                                       }
+                                       syscall( SYS_futex, (uint32_t *)&seq, FUTEX_WAIT_PRIVATE, expect, forever ? nullptr : &ts, nullptr, 0 ) ;
+#elif defined(_WIN32)
+                                       DWORD  ms = forever ? INFINITE : (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>( left ).count() + 1 ;
+                                       WaitOnAddress( (volatile VOID *)&seq, &expect, sizeof(expect), ms ) ;
+#else
+                                       std::unique_lock<std::mutex>  lk( _mtx ) ;
+                                       if (seq.load() == expect)
+                                       {
+                                         if (forever)
+                                           _cv.wait( lk ) ;
+                                         else
+                                           _cv.wait_until( lk, deadline ) ;
+                                       }
+#endif
+                                       (void)left ;
+                                     }
+    void                             _wake( std::atomic<uint32_t> &seq )
+                                     {
+#if defined(__linux__)
+                                       syscall( SYS_futex, (uint32_t *)&seq, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0 ) ;
+#elif defined(_WIN32)
+                                       WakeByAddressAll( (PVOID)&seq ) ;
+#else
+                                       { std::lock_guard<std::mutex>  lk( _mtx ) ; }
+                                       _cv.notify_all() ;
+                                       (void)seq ;
+#endif
+                                     }
+
+  public    :
+    static ParkingLot               &instance() { static ParkingLot  lot ; return lot ; }
+
+    // blocks until ready() or deadline; returns ready()
+    template <class Pred>
+    bool                             park( const void *addr, Pred ready,
+                                           std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max() )
+                                     {
+                                       for (uint32_t i = 0; i < SPINS; i++)
+                                       {
+                                         if (ready())
+                                           return true ;
+                                       }
+                                       _Stripe  &s = _stripe( addr ) ;
+                                       while (true)
+                                       {
+                                         s.waiters.fetch_add( 1 ) ;
+                                         uint32_t  seq = s.seq.load() ;
+                                         if (ready())
+                                         {
+                                           s.waiters.fetch_sub( 1 ) ;
+                                           return true ;
+                                         }
+                                         if (std::chrono::steady_clock::now() >= deadline)
+                                         {
+                                           s.waiters.fetch_sub( 1 ) ;
+                                           return false ;
+                                         }
+                                         _sleep( s.seq, seq, deadline ) ;
+                                         s.waiters.fetch_sub( 1 ) ;
+                                       }
+                                     }
+    // wakes everything parked on addr's stripe, if anything is
+    void                             unpark_all( const void *addr )
+                                     {
+                                       _Stripe  &s = _stripe( addr ) ;
+                                       if (s.waiters.load() == 0)
+                                         return ;
+                                       s.seq.fetch_add( 1 ) ;
+                                       _wake( s.seq ) ;
+                                     }
+
+    // access methods
+    uint32_t                         waiters( const void *addr ) { return _stripe( addr ).waiters.load( std::memory_order_relaxed ) ; }
+} ; // class ParkingLot
+
+}} ; // namespace
@@ -0,0 +1,68 @@
+/*!
+  @file       registry.hpp
+  @brief      SubjectRegistry class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Live-subject registry.  Compiled in only when BOOST_OBSERVERS_REGISTRY is
+  defined; every Subject then registers itself on construction and leaves on
+  destruction.  See graph.hpp for walking and exporting the observer graph.
+*/
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+#include <boost/thread/lock_guard.hpp>
+#include "boost/observe/lfmutex.hpp"
+
+namespace boost { namespace observables {
+
+template <class _Gate> class basic_subject ;
+typedef basic_subject<LockFreeMutex>   Subject ;
+
+class SubjectRegistry
+{
+  private   :
+    LockFreeMutex                    _lock ;
+    std::unordered_set<Subject*>     _live ;
+
+  public    :
+    static SubjectRegistry          &instance()
+                                     {
+                                       static SubjectRegistry  r ;
+                                       return r ;
+                                     }
+
+    void                             add( Subject *s )
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+                                       _live.insert( s ) ;
+                                     }
+    void                             remove( Subject *s )
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+                                       _live.erase( s ) ;
+                                     }
+    size_t                           size()
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+                                       return _live.size() ;
+                                     }
+
+    // calls f( Subject* ) for every live subject.  subjects cannot be destroyed
+    // while this runs, so f must not construct or destroy subjects itself
+    template <class F>
+    void                             for_each( F f )
+                                     {
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+                                       for (Subject *s : _live)
+                                         f( s ) ;
+                                     }
+} ; // class SubjectRegistry
+
+}} ; // namespace
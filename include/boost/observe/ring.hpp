@@ -0,0 +1,306 @@
+/*!
+  @file       ring.hpp
+  @brief      RingSubject template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Sequenced multicast ring (the LMAX disruptor pattern).  A publisher writes
+  each value once into a preallocated slot; every consumer reads it in place,
+  on its own thread and at its own pace, tracking its position with a
+  sequence counter.  A consumer may be made to run after others on the same
+  slot, which gives dependency chains and diamonds without any queue between
+  them.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "boost/observe/subject.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  wait strategies.  wait( ready ) returns once ready() is true; signal() is
+  called after every publish and every consumer batch.
+
+    BusySpinWait   lowest latency, burns a core per waiting thread
+    YieldingWait   spins briefly, then yields the cpu between checks
+    BlockingWait   spins briefly, then sleeps on a condition variable;
+                   signal() costs a fence and a load unless someone sleeps
+*/
+struct BusySpinWait
+{
+  template <class Pred>
+  void                               wait( Pred ready ) { while (!ready()) ; }
+  void                               signal() {}
+} ; // struct BusySpinWait
+
+struct YieldingWait
+{
+  template <class Pred>
+  void                               wait( Pred ready )
+                                     {
+                                       for (uint32_t i = 0; !ready(); i++)
+                                       {
+                                         if (i >= 100)
+                                           std::this_thread::yield() ;
+                                       }
+                                     }
+  void                               signal() {}
+} ; // struct YieldingWait
+
+class BlockingWait
+{
+  private   :
+    std::mutex                       _mtx ;
+    std::condition_variable          _cv ;
+    std::atomic<uint32_t>            _waiters ;
+
+  public    :
+                                     BlockingWait() : _waiters( 0 ) {}
+
+    template <class Pred>
+    void                             wait( Pred ready )
+                                     {
+                                       for (uint32_t i = 0; i < 100; i++)
+                                       {
+                                         if (ready())
+                                           return ;
+                                       }
+                                       std::unique_lock<std::mutex>  lk( _mtx ) ;
+                                       _waiters.fetch_add( 1 ) ;
+                                       while (!ready())
+                                         _cv.wait_for( lk, std::chrono::milliseconds( 1 )) ;   // bounded, so ready() can watch a stop flag
+                                       _waiters.fetch_sub( 1 ) ;
+                                     }
+    void                             signal()
+                                     {
+                                       std::atomic_thread_fence( std::memory_order_seq_cst ) ;
+                                       if (_waiters.load( std::memory_order_relaxed ) != 0)
+                                       {
+                                         { std::lock_guard<std::mutex>  lk( _mtx ) ; }
+                                         _cv.notify_all() ;
+                                       }
+                                     }
+} ; // class BlockingWait
+
+/*!
+  @class RingSubject< T, Wait >
+
+  <b>Description:</b>
+  install()/operator<< and invoke() work as on a Subject, but invoke( v ) only
+  copies v into the next slot and returns; consumers run when their thread
+  calls poll() or run() (or when anyone calls drain()).  typed handlers,
+  added with consume( f ), skip the boost::any packing entirely:
+    f( const T &value, int64_t seq, bool end_of_batch )
+  observers are invoked with { const T*, int64_t seq, this }.
+
+  consume( x, { a, b } ) makes x see a slot only after consumers a and b are
+  done with it.  the publisher waits for the last consumers in each chain, so
+  a slow consumer applies back-pressure rather than losing data.
+
+  <b>Notes:</b>
+  install every consumer before the first invoke.  as with a Subject, the
+  ring owns installed observers and deletes them when it is destroyed.
+  each consumer must be polled by one thread at a time.  concurrent publishers are serialized on a
+  gate; with a single publisher it is never contended.
+*/
+template <class T, class Wait = YieldingWait>
+class RingSubject
+{
+  public    :
+    typedef size_t                                          Consumer ;
+    typedef std::function<void( const T &, int64_t, bool )> Handler ;
+
+  private   :
+    struct alignas(64) _Sequence
+    {
+      std::atomic<int64_t>           v ;
+                                     _Sequence() : v( -1 ) {}
+    } ;
+    struct _Consumer
+    {
+      _Sequence                      seq ;
+      Handler                        handler ;
+      boost::observers::Observer    *obs ;        // owned
+      std::vector<const _Sequence*>  after ;      // empty: follows the publisher
+      bool                           gating ;     // nobody runs after this one
+    } ;
+
+    std::vector<T>                   _ring ;
+    int64_t                          _mask ;
+    _Sequence                        _cursor ;    // last published
+    alignas(64) int64_t              _claim ;     // last claimed (publisher only)
+    int64_t                          _min_gate ;  // cached slowest gating consumer
+#ifdef BOOST_HAS_THREADS
+    LockFreeMutex                    _lock ;      // serializes publishers
+#endif
+    std::vector< std::unique_ptr<_Consumer> >  _consumers ;
+    std::vector<const _Sequence*>    _gates ;
+    Wait                             _wait ;
+
+    static size_t                    _pow2( size_t n )
+                                     {
+                                       size_t  p = 1 ;
+                                       while (p < n)  p <<= 1 ;
+                                       return p ;
+                                     }
+    int64_t                          _slowest() const
+                                     {
+                                       int64_t  m = _cursor.v.load( std::memory_order_relaxed ) ;
+                                       for (const _Sequence *g : _gates)
+                                         m = std::min( m, g->v.load( std::memory_order_acquire )) ;
+                                       return m ;
+                                     }
+    int64_t                          _available( const _Consumer &c ) const
+                                     {
+                                       if (c.after.empty())
+                                         return _cursor.v.load( std::memory_order_acquire ) ;
+                                       int64_t  m = INT64_MAX ;
+                                       for (const _Sequence *s : c.after)
+                                         m = std::min( m, s->v.load( std::memory_order_acquire )) ;
+                                       return m ;
+                                     }
+    Consumer                         _add( _Consumer *c, std::initializer_list<Consumer> after )
+                                     {
+                                       for (Consumer a : after)
+                                       {
+                                         c->after.push_back( &_consumers[a]->seq ) ;
+                                         _consumers[a]->gating = false ;
+                                       }
+                                       c->gating = true ;
+                                       c->seq.v.store( _cursor.v.load()) ;   // starts at the next publish
+                                       _consumers.emplace_back( c ) ;
+
+                                       _gates.clear() ;
+                                       for (auto &x : _consumers)
+                                         if (x->gating)
+                                           _gates.push_back( &x->seq ) ;
+                                       return _consumers.size() - 1 ;
+                                     }
+
+  public    :
+                                     RingSubject( size_t depth = 1024 )
+                                     : _ring( _pow2( depth )), _mask( (int64_t)_pow2( depth ) - 1 ), _claim( -1 ), _min_gate( -1 )
+                                     {}
+                                     RingSubject( const RingSubject & ) = delete ;
+    RingSubject                     &operator=( const RingSubject & ) = delete ;
+                                    ~RingSubject()
+                                     {
+                                       for (auto &c : _consumers)
+                                         delete c->obs ;
+                                     }
+
+    // typed consumer; runs after every consumer in 'after'
+    Consumer                         consume( const Handler &h, std::initializer_list<Consumer> after = {} )
+                                     {
+                                       _Consumer  *c = new _Consumer ;
+                                       c->handler = h ;
+                                       c->obs     = nullptr ;
+                                       return _add( c, after ) ;
+                                     }
+    Consumer                         consume( boost::observers::Observer *o, std::initializer_list<Consumer> after = {} )
+                                     {
+                                       _Consumer  *c = new _Consumer ;
+                                       c->obs = o ;
+                                       return _add( c, after ) ;
+                                     }
+    boost::observers::Observer      *install( boost::observers::Observer *o ) { consume( o ) ; return o ; }
+    RingSubject                     &operator<< ( boost::observers::Observer *o ) { if (o) install( o ) ; return *this ; }
+
+    // fill( T &slot ) writes the value in place; returns its sequence
+    template <class Fill>
+    int64_t                          publish( Fill fill )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<LockFreeMutex>  sc( _lock ) ;
+#endif
+                                       int64_t  seq  = ++_claim ;
+                                       int64_t  wrap = seq - (_mask + 1) ;
+                                       if (wrap > _min_gate)
+                                       {
+                                         _wait.wait( [&](){ return (_min_gate = _slowest()) >= wrap ; } ) ;
+                                       }
+                                       fill( _ring[ seq & _mask ] ) ;
+                                       _cursor.v.store( seq, std::memory_order_release ) ;
+                                       _wait.signal() ;
+                                       return seq ;
+                                     }
+    int64_t                          invoke( const T &v ) { return publish( [&v]( T &slot ){ slot = v ; } ) ; }
+
+    // runs consumer c over up to max ready slots; returns how many it ran
+    size_t                           poll( Consumer c, size_t max = SIZE_MAX )
+                                     {
+                                       _Consumer  &k    = *_consumers[c] ;
+                                       int64_t     next = k.seq.v.load( std::memory_order_relaxed ) + 1 ;
+                                       int64_t     last = _available( k ) ;
+
+                                       if (last < next)
+                                         return 0 ;
+                                       if ((uint64_t)(last - next) >= max)
+                                         last = next + (int64_t)max - 1 ;
+                                       for (int64_t s = next; s <= last; s++)
+                                       {
+                                         const T  &v = _ring[ s & _mask ] ;
+                                         if (k.obs != nullptr)
+                                         {
+                                           if (k.obs->enabled())
+                                             k.obs->invoke({ &v, s, this }) ;
+                                         }
+                                         else
+                                           k.handler( v, s, s == last ) ;
+                                       }
+                                       k.seq.v.store( last, std::memory_order_release ) ;
+                                       _wait.signal() ;
+                                       return (size_t)(last - next + 1) ;
+                                     }
+    // polls c until running turns false, waiting with the ring's strategy
+    void                             run( Consumer c, const std::atomic<bool> &running )
+                                     {
+                                       _Consumer  &k = *_consumers[c] ;
+                                       while (running.load( std::memory_order_relaxed ))
+                                       {
+                                         if (poll( c ) == 0)
+                                           _wait.wait( [&](){ return !running.load( std::memory_order_relaxed ) ||
+                                                                     (_available( k ) > k.seq.v.load( std::memory_order_relaxed )) ; } ) ;
+                                       }
+                                       poll( c ) ;
+                                     }
+    // single-threaded use: runs every consumer, in install order, until caught up
+    size_t                           drain()
+                                     {
+                                       size_t  n = 0 ;
+                                       for (Consumer c = 0; c < _consumers.size(); c++)
+                                         n += poll( c ) ;
+                                       return n ;
+                                     }
+
+    // access methods
+    Consumer                         consumer( boost::observers::Observer *o ) const
+                                     {
+                                       for (Consumer c = 0; c < _consumers.size(); c++)
+                                         if (_consumers[c]->obs == o)
+                                           return c ;
+                                       return SIZE_MAX ;
+                                     }
+    int64_t                          cursor() const { return _cursor.v.load( std::memory_order_acquire ) ; }
+    int64_t                          sequence( Consumer c ) const { return _consumers[c]->seq.v.load( std::memory_order_acquire ) ; }
+    size_t                           capacity() const { return _ring.size() ; }
+    size_t                           nWatchers() const { return _consumers.size() ; }
+} ; // class RingSubject
+
+}} ; // namespace
@@ -0,0 +1,199 @@
+/*!
+  @file       snapshot.hpp
+  @brief      save_snapshot / restore_snapshot for oVector and oMap
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Binary snapshot of a container's contents, for fast restarts.
+
+  file layout (native endian; not portable between architectures):
+    SnapshotHeader                      (64 bytes)
+    value[count]                        oVector
+    { key, value }[count]               oMap, in key order
+
+  Element types must be trivially copyable.  Restore maps the file and loads the
+  container in one bulk reset(): no postInsertCB per element, at most a single
+  resetCB notification when it is done.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "boost/observe/ovector.hpp"
+#include "boost/observe/omap.hpp"
+
+namespace boost { namespace observables {
+
+enum SnapshotKind { SNAP_VECTOR = 1, SNAP_MAP } ;
+
+struct SnapshotHeader
+{
+  uint32_t                 magic ;         // 'OBSS'
+  uint32_t                 version ;
+  uint32_t                 kind ;          // SnapshotKind
+  uint32_t                 key_size ;      // 0 for oVector
+  uint32_t                 value_size ;
+  uint32_t                 entry_size ;    // bytes per element, including padding
+  uint64_t                 count ;
+  uint64_t                 reserved[4] ;
+} ; // struct SnapshotHeader
+
+enum { SNAPSHOT_MAGIC = 0x5353424f, SNAPSHOT_VERSION = 1 } ;
+
+class BadSnapshot { public: BadSnapshot() {} } ;
+
+namespace detail {
+
+template <class Key, class Value>
+struct SnapshotEntry
+{
+  Key                      first ;
+  Value                    second ;
+} ; // struct SnapshotEntry
+
+// writes header + count entries of entry_size bytes; fill( char* ) copies them in
+template <class Fill>
+inline void write_snapshot( const char *path, const SnapshotHeader &h, Fill fill )
+{
+  uint64_t  bytes = sizeof(SnapshotHeader) + h.count * h.entry_size ;
+  {
+    std::filebuf  fb ;
+    if (!fb.open( path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary ))
+      throw BadSnapshot() ;
+    fb.pubseekoff( bytes - 1, std::ios_base::beg ) ;
+    fb.sputc( 0 ) ;
+  }
+  boost::interprocess::file_mapping   file( path, boost::interprocess::read_write ) ;
+  boost::interprocess::mapped_region  region( file, boost::interprocess::read_write ) ;
+  char                               *base = (char *)region.get_address() ;
+
+  region.advise( boost::interprocess::mapped_region::advice_sequential ) ;
+  memcpy( base, &h, sizeof(SnapshotHeader) ) ;
+  fill( base + sizeof(SnapshotHeader) ) ;
+  region.flush() ;
+} // :: write_snapshot
+
+// maps the file and checks it against the expected header
+struct SnapshotReader
+{
+  boost::interprocess::file_mapping   file ;
+  boost::interprocess::mapped_region  region ;
+  const SnapshotHeader               *hdr ;
+  const char                         *data ;
+
+                                      SnapshotReader( const char *path, const SnapshotHeader &want )
+                                      : file( path, boost::interprocess::read_only )
+                                      , region( file, boost::interprocess::read_only )
+                                      {
+                                        region.advise( boost::interprocess::mapped_region::advice_sequential ) ;
+                                        hdr  = (const SnapshotHeader *)region.get_address() ;
+                                        data = (const char *)region.get_address() + sizeof(SnapshotHeader) ;
+                                        if ((region.get_size() < sizeof(SnapshotHeader))
+                                          || (hdr->magic != SNAPSHOT_MAGIC) || (hdr->version != SNAPSHOT_VERSION)
+                                          || (hdr->kind != want.kind) || (hdr->key_size != want.key_size)
+                                          || (hdr->value_size != want.value_size) || (hdr->entry_size != want.entry_size)
+                                          || (region.get_size() < sizeof(SnapshotHeader) + hdr->count * hdr->entry_size))
+                                          throw BadSnapshot() ;
+                                      }
+} ; // struct SnapshotReader
+
+template <class Key, class Value>
+inline SnapshotHeader snapshot_header( uint32_t kind, uint64_t count )
+{
+  SnapshotHeader  h ;
+  memset( &h, 0, sizeof(h) ) ;
+  h.magic      = SNAPSHOT_MAGIC ;
+  h.version    = SNAPSHOT_VERSION ;
+  h.kind       = kind ;
+  h.key_size   = (kind == SNAP_MAP) ? (uint32_t)sizeof(Key) : 0 ;
+  h.value_size = (uint32_t)sizeof(Value) ;
+  h.entry_size = (kind == SNAP_MAP) ? (uint32_t)sizeof(SnapshotEntry<Key,Value>) : (uint32_t)sizeof(Value) ;
+  h.count      = count ;
+  return h ;
+} // :: snapshot_header
+
+} // namespace detail
+
+/*!
+  save_snapshot( container, path )
+
+  writes the container's contents under its gate, so the snapshot is a
+  consistent point-in-time copy.  throws BadSnapshot if the file cannot be
+  created.
+*/
+template <class _Value, class _Gate>
+void save_snapshot( oVector<_Value,_Gate> &v, const char *path )
+{
+  static_assert( std::is_trivially_copyable<_Value>::value, "snapshot values must be trivially copyable" ) ;
+  static_assert( alignof(_Value) <= sizeof(SnapshotHeader), "snapshot values are over-aligned" ) ;
+#ifdef BOOST_HAS_THREADS
+  lock_guard<_Gate>  sc( v.gate() ) ;
+#endif
+  detail::write_snapshot( path, detail::snapshot_header<void*,_Value>( SNAP_VECTOR, v.size() ), [&]( char *p ) {
+    if (!v.empty())
+      memcpy( p, v.data(), v.size() * sizeof(_Value) ) ;
+  }) ;
+} // :: save_snapshot
+
+template <class Key, class Value, class _Pr, class _Gate>
+void save_snapshot( oMap<Key,Value,_Pr,_Gate> &m, const char *path )
+{
+  typedef detail::SnapshotEntry<Key,Value>  _Entry ;
+
+  static_assert( std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                 "snapshot keys and values must be trivially copyable" ) ;
+  static_assert( alignof(_Entry) <= sizeof(SnapshotHeader), "snapshot entries are over-aligned" ) ;
+#ifdef BOOST_HAS_THREADS
+  lock_guard<_Gate>  sc( m.gate() ) ;
+#endif
+  detail::write_snapshot( path, detail::snapshot_header<Key,Value>( SNAP_MAP, m.size() ), [&]( char *p ) {
+    _Entry  *e = (_Entry *)p ;
+    for (auto it = m.begin(); it != m.end(); it++, e++)
+    {
+      memcpy( &e->first, &(*it).first, sizeof(Key) ) ;
+      memcpy( &e->second, &(*it).second, sizeof(Value) ) ;
+    }
+  }) ;
+} // :: save_snapshot
+
+/*!
+  restore_snapshot( container, path, notify )
+
+  replaces the container's contents with the snapshot in one bulk load.
+  postInsertCB/preEraseCB are not fired; resetCB fires once if notify is set.
+  throws BadSnapshot if the file is missing pieces or was written for
+  different element types; the container is untouched in that case.
+*/
+template <class _Value, class _Gate>
+void restore_snapshot( oVector<_Value,_Gate> &v, const char *path, bool notify = true )
+{
+  static_assert( std::is_trivially_copyable<_Value>::value, "snapshot values must be trivially copyable" ) ;
+  detail::SnapshotReader  r( path, detail::snapshot_header<void*,_Value>( SNAP_VECTOR, 0 ) ) ;
+  const _Value           *p = (const _Value *)r.data ;
+
+  v.reset( p, p + r.hdr->count, notify ) ;
+} // :: restore_snapshot
+
+template <class Key, class Value, class _Pr, class _Gate>
+void restore_snapshot( oMap<Key,Value,_Pr,_Gate> &m, const char *path, bool notify = true )
+{
+  typedef detail::SnapshotEntry<Key,Value>  _Entry ;
+
+  static_assert( std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                 "snapshot keys and values must be trivially copyable" ) ;
+  detail::SnapshotReader  r( path, detail::snapshot_header<Key,Value>( SNAP_MAP, 0 ) ) ;
+  const _Entry           *p = (const _Entry *)r.data ;
+
+  m.reset( p, p + r.hdr->count, notify ) ;    // entries are in key order: each insert is at the end hint
+} // :: restore_snapshot
+
+}} ; // namespace
@@ -13,160 +13,671 @@
 
 #include <stdint.h>
 #include <atomic>
+#include <deque>
+#include <exception>
+#include <type_traits>
 #include <boost/thread/lock_guard.hpp>
 #include "boost/observe/observer.hpp"
 #include "boost/observe/lfmutex.hpp"
+#include "boost/observe/gate.hpp"
+#include "boost/observe/workpool.hpp"
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+#  include "boost/observe/instrument.hpp"
+#endif
+#ifdef BOOST_OBSERVERS_REGISTRY
+#  include "boost/observe/registry.hpp"
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#  if __has_include(<coroutine>)
+#    include <coroutine>
+#    include <functional>
+#    define  BOOST_OBSERVERS_HAS_COROUTINES
+#  endif
+#endif
 
 namespace boost { namespace observables {
 
-class Subject 
+// how a Subject delivers notifications raised while the same thread is already
+// dispatching.  DISPATCH_RECURSIVE calls straight through (the original behaviour);
+// DISPATCH_TRAMPOLINE queues the notification on a per-thread queue which the
+// outermost invoke drains iteratively, so deep graphs neither grow the stack nor
+// hold every upstream lock for the whole cascade
+enum DispatchMode { DISPATCH_RECURSIVE = 0, DISPATCH_TRAMPOLINE = 1 } ;
+
+template <class _Gate> class basic_subject ;
+typedef basic_subject<LockFreeMutex>   Subject ;
+
+#ifdef BOOST_OBSERVERS_HAS_COROUTINES
+// resumes a coroutine somewhere other than the dispatching thread; see awaitable.hpp
+typedef std::function<void( std::coroutine_handle<> )>   Executor ;
+class NextAwaiter ;
+#endif
+
+namespace detail {
+
+// per-thread queue of notifications deferred by trampolined subjects.  shared by
+// every gate type, so one drain loop covers a cascade that crosses them
+struct Trampoline
+{
+  struct Pending
+  {
+    void                              *subj ;
+    void                             (*dispatch)( void *, const std::vector<boost::any> * ) ;
+    bool                               has_args ;
+    std::vector<boost::any>            args ;
+  } ;
+
+  std::deque<Pending>                  queue ;
+  bool                                 active ;
+  size_t                               highwater ;
+
+                                       Trampoline() : active( false ), highwater( 0 ) {}
+
+  static Trampoline                   &local()
+                                       {
+                                         static thread_local Trampoline  t ;
+                                         return t ;
+                                       }
+} ; // struct Trampoline
+
+} // namespace detail
+
+/*!
+  @class basic_subject< _Gate >
+
+  <b>Description:</b>
+  the notifier every observable embeds.  most observables are never watched,
+  so the layout is built around that case:
+
+    _obs    tagged pointer.  0 when nothing is installed and no setting differs
+            from the default; an Observer* with the low bit set when exactly
+            one observer is installed; otherwise a pointer to the out-of-line
+            _State (observer vector, block count, dispatch mode, counters,
+            stats, version), allocated on the first install that needs it
+            and kept until the subject is destroyed
+    _src    originator passed to the constructor
+    _lock   the gate; a LockFreeMutex (8 bytes) for Subject
+
+  sizeof(Subject) is 3 pointers (24 bytes on 64-bit) unless lock statistics
+  are compiled in; static asserts below hold that budget.
+
+  _Gate is the threading policy (see gate.hpp).  Subject is the shared,
+  spin-locked default.  basic_subject< NullMutex > is for subjects only one
+  thread ever touches: no lock is taken and _obs is a plain word, not an
+  atomic.
+
+  <b>Notes:</b>
+  bit 1 of _obs marks an outermost dispatch in progress; nested dispatches of
+  the same subject leave expired observers for the outermost one to delete.
+  _obs is only written under the lock.  nWatchers(), enabled(), dispatch()
+  and invoke() read it, and the _State it points to, without the lock; that
+  is what lets an unwatched Numeric skip locking altogether, and why a
+  _State is never freed before the subject itself.
+  set_parallel( threshold, pool ) fans a large dispatch out over a WorkPool;
+  see Observer::set_parallel_safe().
+  version() counts invokes and touches, for pollers that would rather compare
+  a number than install an observer (see ChangeCursor).  the first call
+  creates the _State and tags _obs, so that counting costs the writer one
+  atomic increment and nothing while no one has asked.  concurrent writers
+  never share a count, so a poller sees every change move the number.
+  only Subject takes part in the SubjectRegistry, in slow-observer reports
+  and in co_await; other gates report a null subject.
+*/
+template <class _Gate = LockFreeMutex>
+class basic_subject 
 {
     private  :
-      short                            _block ;        // count of blocks - trigger when first hits 0
-      bool                             _invoked ;      // true when blocked, then tripped by invoke
-      bool                             _is_dead ;      // useful for globals that go out of scope(protection mechanism)
+      struct _State
+      {
+        short                          block ;        // count of blocks - trigger when first hits 0
+        bool                           invoked ;      // true when blocked, then tripped by invoke
+        uint8_t                        mode ;         // DispatchMode
+        uint32_t                       n_deferred ;   // notifications queued on the trampoline
+        uint32_t                       par_threshold ; // fan out to pool at this many observers
+        WorkPool                      *pool ;
+        std::atomic<uint64_t>          version ;      // counted once TAG_VERSIONED is set
+        boost::observers::ObserverVec  vec ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+        SubjectStats                  *stats ;        // allocated on first dispatch
+#endif
+                                       _State() : block( 0 ), invoked( false ), mode( DISPATCH_RECURSIVE ), n_deferred( 0 )
+                                                , par_threshold( 0 ), pool( nullptr ), version( 0 )
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                                , stats( nullptr )
+#endif
+                                       {}
+                                      ~_State()
+                                       {
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                         delete stats ;
+#endif
+                                       }
+      } ;
+
+      // TAG_VERSIONED: the _State counts versions
+      enum { TAG_INLINE = 1, TAG_BUSY = 2, TAG_VERSIONED = 4, TAG_MASK = 7 } ;
+
+      typename gate_traits<_Gate>::template atomic<uintptr_t>  _obs ;
       void                            *_src ;          // who was the originator of the msgs
-#ifdef BOOST_HAS_THREADS
-      LockFreeMutex                    _lock ;
+      _Gate                            _lock ;
+
+      static uintptr_t   _ptr( uintptr_t p ) { return p & ~(uintptr_t)TAG_MASK ; }
+      static boost::observers::Observer *_inline( uintptr_t p ) 
+                         { 
+                           return ((p & TAG_INLINE) && _ptr( p )) ? (boost::observers::Observer *)_ptr( p ) : nullptr ; 
+                         }
+      static _State     *_state( uintptr_t p ) 
+                         { 
+                           return (!(p & TAG_INLINE) && _ptr( p )) ? (_State *)_ptr( p ) : nullptr ; 
+                         }
+      _State            *_st() const { return _state( _obs.load( std::memory_order_acquire )) ; }
+      void               _set( uintptr_t p ) { _obs.store( p, std::memory_order_release ) ; }
+      // out-of-line state, created on demand; lock held
+      _State            *_need_state()
+                         {
+                           uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                           if (_State *st = _state( p ))
+                             return st ;
+                           _State  *st = new _State() ;
+                           if (boost::observers::Observer *o = _inline( p ))
+                             st->vec.push_back( o ) ;
+                           _set( (uintptr_t)st | (p & TAG_BUSY) ) ;
+                           return st ;
+                         }
+
+      static void        _bump( uintptr_t p )
+                          {
+                            _state( p )->version.fetch_add( 1, std::memory_order_release ) ;
+                          }
+      // the outermost dispatch: clears TAG_BUSY and reaps however it leaves
+      struct _Outer
+      {
+        basic_subject   *subj ;
+        bool             reap ;
+
+                         _Outer( basic_subject *s ) : subj( s ), reap( false ) {}
+                        ~_Outer()
+                         {
+                           if (subj == nullptr)
+                             return ;
+                           subj->_set( subj->_obs.load( std::memory_order_relaxed ) & ~(uintptr_t)TAG_BUSY ) ;
+                           if (reap || std::uncaught_exceptions())
+                             subj->_reap() ;
+                         }
+      } ;
+
+      static void        _deferred( void *s, const std::vector<boost::any> *args )
+                          {
+                            ((basic_subject *)s)->_dispatch( args ) ;
+                          }
+      int                _fire( boost::observers::Observer *o, const std::vector<boost::any> *args )
+                          {
+                            int rc = (args == nullptr) ? o->invoke() : o->invoke( *args ) ;
+                            if (rc != 0)
+                              o->disable() ;
+                            return rc ;
+                          }
+      void               _dispatch( const std::vector<boost::any> *args ) 
+                          {
+                            lock_guard<_Gate>  sc( _lock ) ;
+                            uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                            uint64_t  t_start = tsc() ;
+                            uint64_t  t0 = t_start, t1 ;
+                            _State   *stt = _need_state() ;
+                            p = _obs.load( std::memory_order_relaxed ) ;
 #endif
-      boost::observers::ObserverVec    _vec ;
+                            if (_ptr( p ) == 0)
+                              return ;
+
+                            // locked... do some work.  indexed so a handler may install on
+                            // this subject; anything it adds waits for the next notification
+                            _Outer  outer( (p & TAG_BUSY) ? nullptr : this ) ;
+                            bool   &reap = outer.reap ;
+                            if (outer.subj)
+                              _set( p | TAG_BUSY ) ;
+                            if (boost::observers::Observer *o = _inline( p ))
+                            {
+                              if (!o->expired())
+                                _fire( o, args ) ;
+                              reap = o->expired() ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                              t1 = tsc() ;
+                              o->record( t1 - t0 ) ;
+                              Instrument::observed( _as_subject(), o, t1 - t0 ) ;
+#endif
+                            }
+                            else
+                            {
+                              _State  *st = _state( p ) ;
+                              size_t   n  = st->vec.size() ;
+                              bool     fanned = (st->pool != nullptr) && (n >= st->par_threshold) ;
+                              st->invoked = false ;
+                              if (fanned)
+                              {
+                                _fan_out( st, n, args ) ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                t0 = tsc() ;      // fanned observers are not timed one by one
+#endif
+                              }
+                              for (size_t i = 0; (i < n) && (i < st->vec.size()); i++)
+                              {
+                                boost::observers::Observer *o = st->vec[i] ;
+                                if (o->expired())
+                                {
+                                  reap = true ;
+                                  continue ;
+                                }
+                                if (fanned && o->parallel_safe())
+                                  continue ;
+                                _fire( o, args ) ;
+                                if (o->expired())
+                                  reap = true ;
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                                t1 = tsc() ;
+                                o->record( t1 - t0 ) ;
+                                Instrument::observed( _as_subject(), o, t1 - t0 ) ;
+                                t0 = t1 ;
+#endif
+                              }
+                            }
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+                            if (stt->stats == nullptr)
+                              stt->stats = new SubjectStats() ;
+                            stt->stats->invokes++ ;
+                            stt->stats->latency.record( tsc() - t_start ) ;
+#endif
+                          }
+      // runs the parallel-safe observers among the first n on the pool, and
+      // returns once all of them have.  nothing may install or remove on this
+      // subject meanwhile: we hold the gate, and workers never take it
+      void               _fan_out( _State *st, size_t n, const std::vector<boost::any> *args )
+                          {
+                            boost::observers::Observer *const *v = st->vec.data() ;
+                            st->pool->parallel_for( n, 0, [this, v, args]( size_t b, size_t e ) {
+                              for (size_t i = b; i < e; i++)
+                              {
+                                if (v[i]->parallel_safe() && !v[i]->expired())
+                                  _fire( v[i], args ) ;
+                              }
+                            }) ;
+                          }
+      void               _reap()     // drop one-shot observers that have fired; lock held
+                          {
+                            uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                            if (boost::observers::Observer *o = _inline( p ))
+                            {
+                              if (o->expired())
+                              {
+                                _set( 0 ) ;
+                                delete o ;
+                              }
+                              return ;
+                            }
+                            _State  *st = _state( p ) ;
+                            if (st == nullptr)
+                              return ;
+                            size_t  j = 0 ;
+                            for (size_t i = 0; i < st->vec.size(); i++)
+                            {
+                              if (st->vec[i]->expired())
+                                delete st->vec[i] ;
+                              else
+                                st->vec[j++] = st->vec[i] ;
+                            }
+                            st->vec.resize( j ) ;
+                          }
+      void               _bounce( const std::vector<boost::any> *args ) 
+                          {
+                            detail::Trampoline &t = detail::Trampoline::local() ;
+                            if (t.active)
+                            {
+                              // already dispatching on this thread; the outermost invoke picks it up
+                              t.queue.push_back( detail::Trampoline::Pending{ this, &_deferred, args != nullptr, (args != nullptr) ? *args : std::vector<boost::any>() } ) ;
+                              _st()->n_deferred++ ;
+                              if (t.queue.size() > t.highwater)
+                                t.highwater = t.queue.size() ;
+                              return ;
+                            }
+
+                            t.active = true ;
+                            try
+                            {
+                              _dispatch( args ) ;
+                              while (!t.queue.empty())
+                              {
+                                detail::Trampoline::Pending  p = std::move( t.queue.front() ) ;
+                                t.queue.pop_front() ;
+                                p.dispatch( p.subj, p.has_args ? &p.args : nullptr ) ;
+                              }
+                            }
+                            catch (...)
+                            {
+                              t.queue.clear() ;
+                              t.active = false ;
+                              throw ;
+                            }
+                            t.active = false ;
+                          }
+      // hooks that only apply to the default gate
+      Subject           *_as_subject()
+                          {
+                            if constexpr (std::is_same<_Gate, LockFreeMutex>::value)
+                              return this ;
+                            else
+                              return nullptr ;
+                          }
+      void               _registry_add()
+                          {
+#ifdef BOOST_OBSERVERS_REGISTRY
+                            if (Subject *s = _as_subject())
+                              SubjectRegistry::instance().add( s ) ;
+#endif
+                          }
+      void               _registry_remove()
+                          {
+#ifdef BOOST_OBSERVERS_REGISTRY
+                            if (Subject *s = _as_subject())
+                              SubjectRegistry::instance().remove( s ) ;
+#endif
+                          }
+      // true if the notification was absorbed by a block
+      bool               _blocked()
+                          {
+                            _State  *st = _st() ;
+                            if ((st == nullptr) || (st->block <= 0))
+                              return false ;
+                            st->invoked = true ;
+                            return true ;
+                          }
 
     public   :
-                         Subject ( void *src_ = nullptr ) 
+                         basic_subject ( void *src_ = nullptr ) 
+                         : _obs( 0 )
                          {
-                           _block      = 0 ;
-                           _invoked    = false ;
-                           _is_dead    = false ;
                            _src        = src_ ;
+                           _registry_add() ;
                          }
-                         Subject ( const Subject &s ) 
+                         basic_subject ( const basic_subject &s ) 
+                         : _obs( 0 )
                          {
-                           _block      = s._block ;
-                           _invoked    = s._invoked ;
-                           _is_dead    = s._is_dead ;
                            _src        = s._src ;
+                           if (_State *other = s._st())
+                           {
+                             if ((other->block != 0) || other->invoked || (other->mode != DISPATCH_RECURSIVE) || other->pool)
+                             {
+                               _State *st  = new _State() ;
+                               st->block   = other->block ;
+                               st->invoked = other->invoked ;
+                               st->mode    = other->mode ;
+                               st->pool    = other->pool ;
+                               st->par_threshold = other->par_threshold ;
+                               _set( (uintptr_t)st ) ;
+                             }
+                           }
+                           _registry_add() ;
                            // vec not being copied
                          }
-                        ~Subject () 
+                        ~basic_subject () 
                          {
+                           _registry_remove() ;
+                           if (trampolined())
+                           {
+                             // don't leave a dangling entry for this thread's drain loop
+                             std::deque<detail::Trampoline::Pending> &q = detail::Trampoline::local().queue ;
+                             for (auto it = q.begin(); it != q.end(); )
+                               it = ((*it).subj == this) ? q.erase( it ) : it + 1 ;
+                           }
                            clear() ;
-                           _is_dead = true ;
+                           delete _st() ;
+                           _set( 0 ) ;
                          }
 
-      void               block() { _block++ ; } // disables Observer
+      void               block() // disables Observer
+                         {
+                           lock_guard<_Gate>  sc( _lock ) ;
+                           _need_state()->block++ ;
+                         }
       void               clear() 
                          {
-#ifdef BOOST_HAS_THREADS
-                           lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
-                           boost::observers::ObserverVec_iter  it ;
-                           for (it = _vec.begin(); it != _vec.end(); it++)
+                           lock_guard<_Gate>  sc( _lock ) ;
+                           uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                           if (boost::observers::Observer *o = _inline( p ))
                            {
-                             delete( (*it) ) ;
+                             _set( p & TAG_BUSY ) ;
+                             delete o ;
+                           }
+                           else if (_State *st = _state( p ))
+                           {
+                             boost::observers::ObserverVec_iter  it ;
+                             for (it = st->vec.begin(); it != st->vec.end(); it++)
+                             {
+                               delete( (*it) ) ;
+                             }
+                             st->vec.clear() ;
                            }
-                           _vec.clear() ;
                          }
       boost::observers::Observer          *install ( boost::observers::Observer *c ) 
                          {
                            if (c == nullptr)
                              return c ;
 
-#ifdef BOOST_HAS_THREADS
-                           lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
-                           _vec.push_back( c ) ;
+                           lock_guard<_Gate>  sc( _lock ) ;
+                           uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                           if (_ptr( p ) == 0)
+                             _set( (uintptr_t)c | TAG_INLINE | (p & TAG_BUSY) ) ;
+                           else
+                             _need_state()->vec.push_back( c ) ;
 
                            return c ;
                          }
       void               invoke () 
                           {
-                            if (_block > 0)
+                            uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                            if (p == 0)
                             {
-                              _invoked = true ;
-                              return ;
-                            }
-
-#ifdef BOOST_HAS_THREADS
-                            lock_guard<LockFreeMutex>  sc( _lock ) ;
+#ifndef BOOST_OBSERVERS_INSTRUMENT
+                              return ;    // nobody watching and nothing blocked
 #endif
-                            // locked... do some work
-                            boost::observers::ObserverVec_iter  it ;
-                            for (it = _vec.begin(); it != _vec.end(); it++)
+                            }
+                            else
                             {
-                              if ((*it)->invoke() != 0)
-                                (*it)->disable() ;
+                              if (p & TAG_VERSIONED)
+                                _bump( p ) ;
+                              if (_blocked())
+                                return ;
                             }
-                            _invoked = false ;
+                            if (trampolined())
+                              _bounce( nullptr ) ;
+                            else
+                              _dispatch( nullptr ) ;
                           }
       void               invoke ( const std::vector<boost::any> &args ) 
                           {
-                            if (_block > 0)
+                            uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                            if (p == 0)
                             {
-                              _invoked = true ;
+#ifndef BOOST_OBSERVERS_INSTRUMENT
                               return ;
-                            }
-#ifdef BOOST_HAS_THREADS
-                            lock_guard<LockFreeMutex>  sc( _lock ) ;
 #endif
-                            // locked... do some work
-                            boost::observers::ObserverVec_iter  it ;
-                            for (it = _vec.begin(); it != _vec.end(); it++)
+                            }
+                            else
                             {
-                              if ((*it)->invoke( args ) != 0)
-                                (*it)->disable() ;
+                              if (p & TAG_VERSIONED)
+                                _bump( p ) ;
+                              if (_blocked())
+                                return ;
                             }
-                            _invoked = false ;
+                            if (trampolined())
+                              _bounce( &args ) ;
+                            else
+                              _dispatch( &args ) ;
                           }
       boost::observers::Observer          *remove ( boost::observers::Observer *cb ) 
                           {
                             if (cb == nullptr)
                               return cb ;
 
-#ifdef BOOST_HAS_THREADS
-                            lock_guard<LockFreeMutex>  sc( _lock ) ;
-#endif
+                            lock_guard<_Gate>  sc( _lock ) ;
                             // locked... do some work
-                            boost::observers::ObserverVec_iter  it ;
-                            for (it = _vec.begin(); it != _vec.end(); it++)
+                            uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                            if (_inline( p ) == cb)
+                              _set( p & TAG_BUSY ) ;
+                            else if (_State *st = _state( p ))
                             {
-                              if ((*it) == cb)
+                              boost::observers::ObserverVec_iter  it ;
+                              for (it = st->vec.begin(); it != st->vec.end(); )
                               {
-                                _vec.erase(it) ;
+                                if ((*it) == cb)
+                                  it = st->vec.erase(it) ;
+                                else
+                                  it++ ;
                               }
                             }
                             return cb ;
                           }
       int                unblock() // enables Observer && triggers
                           {
-                            if (_block != 0)
+                            _State  *st = _st() ;
+                            if ((st != nullptr) && (st->block != 0))
                             {
-                              _block-- ;
-                              if ((_block == 0) && _invoked)
+                              st->block-- ;
+                              if ((st->block == 0) && st->invoked)
                               {
                                 invoke() ;
                               }
+                              return st->block ;
                             }
-                            return _block ;
+                            return 0 ;
                           }
       int                unblock( const std::vector<boost::any> &args ) 
                           {
-                            if (_block != 0)
+                            _State  *st = _st() ;
+                            if ((st != nullptr) && (st->block != 0))
                             {
-                              _block-- ;
-                              if (_block == 0)
+                              st->block-- ;
+                              if (st->block == 0)
                                 invoke(args) ;
+                              return st->block ;
                             }
-                            return _block ;
+                            return 0 ;
                           }
 
-      Subject            &operator<< ( boost::observers::Observer *o ) { if (o) install( o ) ; return *this ; }
+      basic_subject      &operator<< ( boost::observers::Observer *o ) { if (o) install( o ) ; return *this ; }
+      void               set_dispatch( DispatchMode m ) 
+                          {
+                            lock_guard<_Gate>  sc( _lock ) ;
+                            if ((m == DISPATCH_RECURSIVE) && (_st() == nullptr))
+                              return ;
+                            _need_state()->mode = (uint8_t)m ;
+                          }
+      // above threshold observers, runs the parallel-safe ones on pool and the
+      // rest on the calling thread, after them; invoke still returns only once
+      // all have run.  a null pool turns fan-out off
+      void               set_parallel( size_t threshold, WorkPool *pool ) 
+                          {
+                            lock_guard<_Gate>  sc( _lock ) ;
+                            if ((pool == nullptr) && (_st() == nullptr))
+                              return ;
+                            _State  *st = _need_state() ;
+                            st->pool          = pool ;
+                            st->par_threshold = (uint32_t)threshold ;
+                          }
+      // counts a change without notifying anyone, e.g. a write nobody watches.
+      // the seq_cst load pairs with the fence in version_counter(): a write
+      // racing the first version() is either counted or visible to its caller
+      void               touch()
+                          {
+                            uintptr_t  p = _obs.load( std::memory_order_seq_cst ) ;
+                            if (p & TAG_VERSIONED)
+                              _bump( p ) ;
+                          }
+      // the counter itself, for a ChangeCursor; starts counting on first use
+      const std::atomic<uint64_t>  &version_counter()
+                          {
+                            uintptr_t  p = _obs.load( std::memory_order_acquire ) ;
+                            if (!(p & TAG_VERSIONED))
+                            {
+                              lock_guard<_Gate>  sc( _lock ) ;
+                              _need_state() ;
+                              p = _obs.load( std::memory_order_relaxed ) | TAG_VERSIONED ;
+                              _set( p ) ;
+                              std::atomic_thread_fence( std::memory_order_seq_cst ) ;
+                            }
+                            return _state( p )->version ;
+                          }
+      uint64_t           version() { return version_counter().load( std::memory_order_acquire ) ; }
+
+#ifdef BOOST_OBSERVERS_HAS_COROUTINES
+      NextAwaiter        next() ;                      // co_await s.next() ; defined in awaitable.hpp
+      NextAwaiter        next( const Executor &e ) ;
+#endif
 
       // access methods
-      inline bool        enabled() const { return (_block == 0) ; }
-      inline size_t      nWatchers() const { return _vec.size() ; }
-      LockFreeMutex     &lock() { return _lock ; }
+      inline bool        enabled() const 
+                          { 
+                            _State  *st = _st() ;
+                            return (st == nullptr) || (st->block == 0) ; 
+                          }
+      inline size_t      nWatchers() const 
+                          { 
+                            uintptr_t  p = _obs.load( std::memory_order_acquire ) ;
+                            if (_ptr( p ) == 0)
+                              return 0 ;
+                            if (p & TAG_INLINE)
+                              return 1 ;
+                            return _state( p )->vec.size() ;
+                          }
+      boost::observers::ObserverVec  watchers() 
+                         {
+                           lock_guard<_Gate>  sc( _lock ) ;
+                           uintptr_t  p = _obs.load( std::memory_order_relaxed ) ;
+                           if (boost::observers::Observer *o = _inline( p ))
+                             return boost::observers::ObserverVec( 1, o ) ;
+                           if (_State *st = _state( p ))
+                             return st->vec ;
+                           return boost::observers::ObserverVec() ;
+                         }
+      _Gate             &lock() { return _lock ; }
       void              *src() const { return _src ; }
-} ; // class Subject
+      DispatchMode       dispatch() const 
+                          { 
+                            _State  *st = _st() ;
+                            return (st == nullptr) ? DISPATCH_RECURSIVE : (DispatchMode)st->mode ; 
+                          }
+      inline bool        trampolined() const { return (dispatch() == DISPATCH_TRAMPOLINE) ; }
+      WorkPool          *pool() const 
+                          { 
+                            _State  *st = _st() ;
+                            return (st == nullptr) ? nullptr : st->pool ; 
+                          }
+      uint32_t           nDeferred() const 
+                          { 
+                            _State  *st = _st() ;
+                            return (st == nullptr) ? 0 : st->n_deferred ; 
+                          }
+#ifdef BOOST_OBSERVERS_INSTRUMENT
+      const SubjectStats *stats() const                    // nullptr until first dispatch
+                          { 
+                            _State  *st = _st() ;
+                            return (st == nullptr) ? nullptr : st->stats ; 
+                          }
+#endif
+
+      // per-thread trampoline state; pending() is non-zero only while a drain is running
+      static size_t      pending() { return detail::Trampoline::local().queue.size() ; }
+      static size_t      pendingHighwater() { return detail::Trampoline::local().highwater ; }
+} ; // class basic_subject
+
+#if defined(BOOST_HAS_THREADS) && !defined(BOOST_OBSERVERS_LOCK_STATS)
+static_assert( sizeof(LockFreeMutex) <= sizeof(void*), "LockFreeMutex outgrew its slot in Subject" ) ;
+static_assert( sizeof(Subject) <= 3 * sizeof(void*), "Subject exceeds its 3-pointer budget" ) ;
+#endif
+static_assert( sizeof(basic_subject<NullMutex>) <= 3 * sizeof(void*), "basic_subject<NullMutex> exceeds its 3-pointer budget" ) ;
 
 }} ;
 
+#ifdef BOOST_OBSERVERS_HAS_COROUTINES
+#  include "boost/observe/awaitable.hpp"
+#endif
@@ -0,0 +1,306 @@
+/*!
+  @file       subscription.hpp
+  @brief      SubscriptionMatrix template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Many-to-many subscriptions (thousands of sources, each watched by thousands
+  of targets) stored as one compressed sparse row index instead of a Subject
+  per source and an Observer per edge.
+
+    _rows    _rows[s] .. _rows[s+1] is the slice of _edges belonging to source s
+    _edges   { target, ctx } per edge, each row sorted by target
+    _adds    edges added since the last compact(), in arrival order
+
+  An edge costs sizeof(Edge) bytes (8 with a 32-bit context) against the
+  Observer allocation plus the ObserverVec slot of the per-edge form.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <boost/thread/lock_guard.hpp>
+#include "boost/observe/observer.hpp"
+#include "boost/observe/lfmutex.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class SubscriptionMatrix< Ctx, _Gate >
+
+  <b>Description:</b>
+  sources are dense 32-bit ids and targets 31-bit ids, e.g. stock and
+  portfolio indices.  each edge carries a small Ctx, e.g. a slot in the target.
+  dispatch( src, f ) calls f( target, ctx ) for every live edge of src; it
+  is a linear scan over a contiguous row.  observer( src, f ) wraps that in
+  a single Observer, so one install on a source's Subject replaces an
+  Observer per edge.
+
+  add() and remove() are cheap and may be batched: adds are queued and
+  merged into the index by compact(), removes tombstone the edge in place.
+  dispatch() compacts first once COMPACT_ADDS adds are queued, or when a
+  quarter of the index is tombstones, so a batch is merged once, on the
+  first dispatch after it.  short of that, dispatch( src ) also walks the
+  queue for src's adds, so a trickle of adds does not copy the index each
+  time.
+
+  <b>Notes:</b>
+  adding an existing edge replaces its ctx.  handlers may add and remove
+  edges; neither moves the index, and a compaction requested meanwhile waits
+  until the outermost dispatch returns.  an edge added during a dispatch is
+  seen from the next one.
+*/
+template <class Ctx = uint32_t, class _Gate = LockFreeMutex>
+class SubscriptionMatrix
+{
+  public    :
+    enum : uint32_t { DEAD = 0x80000000 } ;     // set in a removed edge's target; ids are 31 bits
+    enum : size_t   { COMPACT_ADDS = 1024 } ;    // queued adds that make dispatch() compact
+
+    struct Edge
+    {
+      uint32_t                       target ;
+      Ctx                            ctx ;
+    } ;
+
+  private   :
+    struct _Add
+    {
+      uint32_t                       src ;
+      Edge                           edge ;
+    } ;
+
+#ifdef BOOST_HAS_THREADS
+    _Gate                            _gate ;
+#endif
+    std::vector<size_t>              _rows ;      // n_sources + 1 offsets
+    std::vector<Edge>                _edges ;
+    std::vector<_Add>                _adds ;
+    size_t                           _dead ;      // tombstoned edges in _edges
+    uint32_t                         _depth ;     // dispatches in progress
+
+    static bool                      _by_target( const Edge &a, const Edge &b ) { return (a.target & ~DEAD) < (b.target & ~DEAD) ; }
+    // the live or removed slot of src -> target in the index; null if none
+    Edge                            *_find( uint32_t src, uint32_t target )
+                                     {
+                                       if ((size_t)src + 1 >= _rows.size())
+                                         return nullptr ;
+                                       Edge  *b  = _edges.data() + _rows[ src ] ;
+                                       Edge  *e  = _edges.data() + _rows[ src + 1 ] ;
+                                       Edge   k  = { target, Ctx() } ;
+                                       Edge  *it = std::lower_bound( b, e, k, &_by_target ) ;
+                                       return ((it != e) && (((*it).target & ~DEAD) == target)) ? it : nullptr ;
+                                     }
+    void                             _compact()
+                                     {
+                                       // last add of an edge wins
+                                       std::stable_sort( _adds.begin(), _adds.end(), []( const _Add &a, const _Add &b ){
+                                         return (a.src < b.src) || ((a.src == b.src) && (a.edge.target < b.edge.target)) ;
+                                       }) ;
+                                       size_t  n_src = (_rows.empty() ? 0 : _rows.size() - 1) ;
+                                       if (!_adds.empty() && ((size_t)_adds.back().src + 1 > n_src))
+                                         n_src = (size_t)_adds.back().src + 1 ;
+
+                                       std::vector<size_t>  rows( n_src + 1, 0 ) ;
+                                       std::vector<Edge>    edges ;
+                                       edges.reserve( _edges.size() - _dead + _adds.size() ) ;
+
+                                       size_t  a = 0 ;
+                                       for (size_t s = 0; s < n_src; s++)
+                                       {
+                                         rows[ s ] = edges.size() ;
+                                         if (s + 1 < _rows.size())
+                                         {
+                                           for (size_t i = _rows[ s ]; i < _rows[ s + 1 ]; i++)
+                                             if (!(_edges[ i ].target & DEAD))
+                                               edges.push_back( _edges[ i ] ) ;
+                                         }
+                                         size_t  mid = edges.size() ;       // old row, then its adds
+                                         for (; (a < _adds.size()) && (_adds[ a ].src == s); a++)
+                                         {
+                                           if ((a + 1 < _adds.size()) && (_adds[ a + 1 ].src == s) &&
+                                               (_adds[ a + 1 ].edge.target == _adds[ a ].edge.target))
+                                             continue ;
+                                           edges.push_back( _adds[ a ].edge ) ;
+                                         }
+                                         std::inplace_merge( edges.begin() + rows[ s ], edges.begin() + mid, edges.end(), &_by_target ) ;
+                                       }
+                                       rows[ n_src ] = edges.size() ;
+
+                                       _rows.swap( rows ) ;
+                                       _edges.swap( edges ) ;
+                                       _adds.clear() ;
+                                       _adds.shrink_to_fit() ;   // a bulk load should not leave its queue behind
+                                       _dead = 0 ;
+                                     }
+
+  public    :
+                                     SubscriptionMatrix() : _dead( 0 ), _depth( 0 ) {}
+                                     SubscriptionMatrix( const SubscriptionMatrix & ) = delete ;
+    SubscriptionMatrix              &operator=( const SubscriptionMatrix & ) = delete ;
+
+    // subscribes target to src; an existing edge takes the new ctx.  false
+    // if target does not fit in 31 bits
+    bool                             add( uint32_t src, uint32_t target, const Ctx &ctx = Ctx() )
+                                     {
+                                       if (target >= DEAD)
+                                         return false ;
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       if (Edge *e = _find( src, target ))
+                                       {
+                                         if (e->target & DEAD)
+                                           _dead-- ;
+                                         e->target = target ;
+                                         e->ctx    = ctx ;
+                                         return true ;
+                                       }
+                                       _adds.push_back( _Add{ src, Edge{ target, ctx } } ) ;
+                                       return true ;
+                                     }
+    // false if there was no such edge
+    bool                             remove( uint32_t src, uint32_t target )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       bool  found = false ;
+                                       for (size_t i = 0; i < _adds.size(); )
+                                       {
+                                         if ((_adds[ i ].src == src) && (_adds[ i ].edge.target == target))
+                                         {
+                                           _adds.erase( _adds.begin() + i ) ;
+                                           found = true ;
+                                         }
+                                         else
+                                           i++ ;
+                                       }
+                                       Edge  *e = _find( src, target ) ;
+                                       if ((e != nullptr) && !(e->target & DEAD))
+                                       {
+                                         _tombstone( e ) ;
+                                         found = true ;
+                                       }
+                                       return found ;
+                                     }
+    // unsubscribes target from every source; returns how many edges it had
+    size_t                           remove_target( uint32_t target )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       size_t  n = _adds.size() ;
+                                       _adds.erase( std::remove_if( _adds.begin(), _adds.end(), [target]( const _Add &a ){
+                                         return a.edge.target == target ;
+                                       }), _adds.end() ) ;
+                                       n -= _adds.size() ;
+                                       for (Edge &e : _edges)
+                                       {
+                                         if (e.target == target)
+                                         {
+                                           _tombstone( &e ) ;
+                                           n++ ;
+                                         }
+                                       }
+                                       return n ;
+                                     }
+    // merges queued adds and drops tombstones; deferred while dispatching
+    void                             compact()
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       if ((_depth == 0) && (!_adds.empty() || (_dead != 0)))
+                                         _compact() ;
+                                     }
+
+    // f( uint32_t target, const Ctx &ctx ) for each live edge of src
+    template <class F>
+    size_t                           dispatch( uint32_t src, F f )
+                                     {
+#ifdef BOOST_HAS_THREADS
+                                       lock_guard<_Gate>  sc( _gate ) ;
+#endif
+                                       if ((_depth == 0) && ((_adds.size() >= COMPACT_ADDS) || (_dead > _edges.size() / 4)))
+                                         _compact() ;
+
+                                       // src's queued adds, last add of an edge wins; copied, as handlers may add
+                                       std::vector<Edge>  queued ;
+                                       for (const _Add &a : _adds)
+                                         if (a.src == src)
+                                           queued.push_back( a.edge ) ;
+                                       std::stable_sort( queued.begin(), queued.end(), &_by_target ) ;
+
+                                       size_t  n = 0 ;
+                                       size_t  b = ((size_t)src + 1 < _rows.size()) ? _rows[ src ] : 0 ;
+                                       size_t  e = ((size_t)src + 1 < _rows.size()) ? _rows[ src + 1 ] : 0 ;
+                                       _depth++ ;
+                                       try
+                                       {
+                                         for (size_t i = b; i < e; i++)
+                                         {
+                                           const Edge  &x = _edges[ i ] ;
+                                           if (x.target & DEAD)
+                                             continue ;
+                                           f( x.target, x.ctx ) ;
+                                           n++ ;
+                                         }
+                                         for (size_t i = 0; i < queued.size(); i++)
+                                         {
+                                           if ((i + 1 < queued.size()) && (queued[ i + 1 ].target == queued[ i ].target))
+                                             continue ;
+                                           f( queued[ i ].target, queued[ i ].ctx ) ;
+                                           n++ ;
+                                         }
+                                       }
+                                       catch (...)
+                                       {
+                                         _depth-- ;
+                                         throw ;
+                                       }
+                                       _depth-- ;
+                                       return n ;
+                                     }
+    // an Observer that dispatches src with f( target, ctx, args ); install it
+    // on the source's Subject.  the matrix must outlive it
+    template <class F>
+    boost::observers::Observer      *observer( uint32_t src, F f )
+                                     {
+                                       return new boost::observers::Lambda( [this, src, f]( const std::vector<boost::any> &args ) {
+                                         dispatch( src, [&]( uint32_t target, const Ctx &ctx ){ f( target, ctx, args ) ; } ) ;
+                                       }) ;
+                                     }
+
+    // access methods
+    size_t                           sources() const { return _rows.empty() ? 0 : _rows.size() - 1 ; }
+    size_t                           edges() const { return _edges.size() - _dead + _adds.size() ; }
+    size_t                           pending() const { return _adds.size() ; }
+    size_t                           tombstones() const { return _dead ; }
+    size_t                           bytes() const
+                                     {
+                                       return _rows.capacity() * sizeof(size_t) + _edges.capacity() * sizeof(Edge)
+                                            + _adds.capacity() * sizeof(_Add) ;
+                                     }
+#ifdef BOOST_HAS_THREADS
+    _Gate                           &gate() { return _gate ; }
+#endif
+
+  private   :
+    void                             _tombstone( Edge *e )
+                                     {
+                                       if (!(e->target & DEAD))
+                                       {
+                                         e->target |= DEAD ;
+                                         _dead++ ;
+                                       }
+                                     }
+} ; // class SubscriptionMatrix
+
+}} ; // namespace
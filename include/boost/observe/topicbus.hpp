@@ -0,0 +1,292 @@
+/*!
+  @file       topicbus.hpp
+  @brief      TopicBus template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  Hierarchical topics ("equities.NYSE.IBM.trade") with wildcard
+  subscriptions ("equities.*.IBM.*") on top of EventMap.
+
+    topics      interned once to dense ids; a topic's segments are interned
+                too, so matching compares integers, never strings
+    patterns    one Subject each, kept in an EventMap keyed by pattern id,
+                and a trie of segment ids with a '*' edge per node
+    resolved    per topic id, the list of pattern subjects it matches.  built
+                by walking the trie on the first publish, then reused until
+                a subscription changes
+*/
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "boost/observe/eventmap.hpp"
+
+namespace boost { namespace observables {
+
+/*!
+  @class TopicBus< _Gate >
+
+  <b>Description:</b>
+  subscribe( pattern ) returns the pattern's Subject; install observers on
+  it.  a '*' segment matches any one segment.  publish( topic, args ) invokes
+  every matching subject with { topic id, args... }, like EventMap::invoke,
+  or the default subject when none matches.  publishing by id skips the
+  string hash.
+
+  <b>Notes:</b>
+  a subscribe or unsubscribe bumps the epoch; resolved lists built under an
+  older epoch are rebuilt when next published.  handlers may subscribe and
+  unsubscribe; the publish in progress still notifies the list it started
+  with, and an unsubscribed subject lives until the outermost publish
+  returns.  trie nodes of dropped patterns are kept for reuse.
+*/
+template <class _Gate = LockFreeMutex>
+class TopicBus
+{
+  public    :
+    typedef basic_subject< _Gate >   Subject ;
+    typedef std::vector<Subject *>   Subscribers ;
+
+    enum : uint32_t { NONE = 0xffffffff } ;
+
+  private   :
+    struct _Node
+    {
+      std::unordered_map<uint32_t, uint32_t>  next ;    // segment id -> node
+      uint32_t                       star ;             // node under '*'
+      uint32_t                       pattern ;          // pattern ending here
+                                     _Node() : star( NONE ), pattern( NONE ) {}
+    } ;
+    struct _Resolved
+    {
+      uint64_t                       epoch ;
+      std::shared_ptr<const Subscribers>  subs ;
+    } ;
+
+    _Gate                            _lock ;
+    EventMap<uint32_t, _Gate>        _subs ;            // pattern id -> Subject
+    std::unordered_map<std::string, uint32_t>  _topic_ids ;
+    std::vector<std::string>         _topics ;
+    std::vector< std::vector<uint32_t> >  _topic_segs ;
+    std::vector<_Resolved>           _resolved ;        // by topic id
+    std::unordered_map<std::string, uint32_t>  _seg_ids ;
+    std::unordered_map<std::string, uint32_t>  _pattern_ids ;
+    std::vector<uint32_t>            _pattern_node ;    // by pattern id; NONE once dropped
+    std::vector<_Node>               _trie ;
+    std::vector<uint32_t>            _doomed ;          // unsubscribed during a publish
+    uint64_t                         _epoch ;
+    uint32_t                         _depth ;           // publishes in progress
+
+    uint32_t                         _seg( const std::string &s )
+                                     {
+                                       auto  r = _seg_ids.emplace( s, (uint32_t)_seg_ids.size() ) ;
+                                       return (*r.first).second ;
+                                     }
+    template <class F>
+    static void                      _split( const std::string &t, F f )
+                                     {
+                                       size_t  b = 0 ;
+                                       while (true)
+                                       {
+                                         size_t  e = t.find( '.', b ) ;
+                                         f( t.substr( b, (e == std::string::npos) ? std::string::npos : e - b )) ;
+                                         if (e == std::string::npos)
+                                           return ;
+                                         b = e + 1 ;
+                                       }
+                                     }
+    uint32_t                         _intern( const std::string &topic )
+                                     {
+                                       auto  r = _topic_ids.emplace( topic, (uint32_t)_topics.size() ) ;
+                                       if (r.second)
+                                       {
+                                         _topics.push_back( topic ) ;
+                                         _topic_segs.emplace_back() ;
+                                         std::vector<uint32_t>  &segs = _topic_segs.back() ;
+                                         _split( topic, [&]( const std::string &s ){ segs.push_back( _seg( s )) ; } ) ;
+                                         _resolved.push_back( _Resolved{ 0, nullptr } ) ;
+                                       }
+                                       return (*r.first).second ;
+                                     }
+    void                             _match( uint32_t node, const std::vector<uint32_t> &segs, size_t d, std::vector<uint32_t> &out ) const
+                                     {
+                                       const _Node  &n = _trie[ node ] ;
+                                       if (d == segs.size())
+                                       {
+                                         if (n.pattern != NONE)
+                                           out.push_back( n.pattern ) ;
+                                         return ;
+                                       }
+                                       auto  it = n.next.find( segs[ d ] ) ;
+                                       if (it != n.next.end())
+                                         _match( (*it).second, segs, d + 1, out ) ;
+                                       if (n.star != NONE)
+                                         _match( n.star, segs, d + 1, out ) ;
+                                     }
+    const std::shared_ptr<const Subscribers>  &_resolve( uint32_t topic )
+                                     {
+                                       _Resolved  &r = _resolved[ topic ] ;
+                                       if (r.epoch != _epoch)
+                                       {
+                                         std::vector<uint32_t>  ids ;
+                                         _match( 0, _topic_segs[ topic ], 0, ids ) ;
+                                         std::sort( ids.begin(), ids.end() ) ;        // subscription order
+                                         std::shared_ptr<Subscribers>  subs = std::make_shared<Subscribers>() ;
+                                         subs->reserve( ids.size() ) ;
+                                         for (uint32_t id : ids)
+                                           subs->push_back( _subs.find( id )) ;
+                                         r.subs  = subs ;
+                                         r.epoch = _epoch ;
+                                       }
+                                       return r.subs ;
+                                     }
+    void                             _bury()
+                                     {
+                                       for (uint32_t id : _doomed)
+                                         _subs.erase( id ) ;
+                                       _doomed.clear() ;
+                                     }
+
+  public    :
+                                     TopicBus() : _trie( 1 ), _epoch( 1 ), _depth( 0 ) {}
+                                     TopicBus( const TopicBus & ) = delete ;
+    TopicBus                        &operator=( const TopicBus & ) = delete ;
+
+    // the topic's id, assigned on first sight
+    uint32_t                         intern( const std::string &topic )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       return _intern( topic ) ;
+                                     }
+    // the topic with that id; empty if it was never interned
+    const std::string               &topic( uint32_t id )
+                                     {
+                                       static const std::string  none ;
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       return (id < _topics.size()) ? _topics[ id ] : none ;
+                                     }
+
+    // the pattern's subject; subscribing to the same pattern again returns it
+    Subject                         &subscribe( const std::string &pattern )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       auto  r = _pattern_ids.emplace( pattern, (uint32_t)_pattern_node.size() ) ;
+                                       uint32_t  id = (*r.first).second ;
+                                       if (r.second)
+                                       {
+                                         uint32_t  node = 0 ;
+                                         _split( pattern, [&]( const std::string &s ){
+                                           uint32_t  nx ;
+                                           if (s == "*")
+                                           {
+                                             if ((nx = _trie[ node ].star) == NONE)
+                                             {
+                                               nx = (uint32_t)_trie.size() ;
+                                               _trie.emplace_back() ;
+                                               _trie[ node ].star = nx ;
+                                             }
+                                           }
+                                           else
+                                           {
+                                             uint32_t  seg = _seg( s ) ;
+                                             auto      it  = _trie[ node ].next.find( seg ) ;
+                                             if (it == _trie[ node ].next.end())
+                                             {
+                                               nx = (uint32_t)_trie.size() ;
+                                               _trie.emplace_back() ;
+                                               _trie[ node ].next.emplace( seg, nx ) ;
+                                             }
+                                             else
+                                               nx = (*it).second ;
+                                           }
+                                           node = nx ;
+                                         }) ;
+                                         _trie[ node ].pattern = id ;
+                                         _pattern_node.push_back( node ) ;
+                                         _epoch++ ;
+                                       }
+                                       return _subs.get( id ) ;
+                                     }
+    // drops the pattern's subject and deletes its observers
+    bool                             unsubscribe( const std::string &pattern )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       auto  it = _pattern_ids.find( pattern ) ;
+                                       if (it == _pattern_ids.end())
+                                         return false ;
+                                       uint32_t  id = (*it).second ;
+                                       _trie[ _pattern_node[ id ] ].pattern = NONE ;
+                                       _pattern_node[ id ] = NONE ;
+                                       _pattern_ids.erase( it ) ;
+                                       _doomed.push_back( id ) ;
+                                       if (_depth == 0)
+                                         _bury() ;
+                                       _epoch++ ;
+                                       return true ;
+                                     }
+
+    // notifies each pattern subject matching topic with { topic, args... };
+    // returns how many matched.  an id that was never interned reaches no one
+    size_t                           publish( uint32_t topic, const std::vector<boost::any> &args_ = std::vector<boost::any>() )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       if (topic >= _topics.size())
+                                         return 0 ;
+                                       std::shared_ptr<const Subscribers>  subs = _resolve( topic ) ;
+
+                                       std::vector<boost::any>  args ;
+                                       args.reserve( args_.size() + 1 ) ;
+                                       args.push_back( topic ) ;
+                                       args.insert( args.end(), args_.begin(), args_.end() ) ;
+
+                                       _depth++ ;
+                                       try
+                                       {
+                                         if (subs->empty())
+                                           _subs.get_default().invoke( args ) ;
+                                         for (Subject *s : *subs)
+                                           s->invoke( args ) ;
+                                       }
+                                       catch (...)
+                                       {
+                                         if (--_depth == 0)
+                                           _bury() ;
+                                         throw ;
+                                       }
+                                       if (--_depth == 0)
+                                         _bury() ;
+                                       return subs->size() ;
+                                     }
+    size_t                           publish( const std::string &topic, const std::vector<boost::any> &args_ = std::vector<boost::any>() )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       return publish( _intern( topic ), args_ ) ;
+                                     }
+
+    // the subjects a publish of topic reaches now
+    Subscribers                      subscribers( uint32_t topic )
+                                     {
+                                       lock_guard<_Gate>  sc( _lock ) ;
+                                       if (topic >= _topics.size())
+                                         return Subscribers() ;
+                                       return *_resolve( topic ) ;
+                                     }
+
+    // access methods
+    Subject                         &get_default() { return _subs.get_default() ; }
+    size_t                           topics() { lock_guard<_Gate>  sc( _lock ) ; return _topics.size() ; }
+    size_t                           patterns() { lock_guard<_Gate>  sc( _lock ) ; return _pattern_ids.size() ; }
+    uint64_t                         epoch() { lock_guard<_Gate>  sc( _lock ) ; return _epoch ; }
+    _Gate                           &gate() { return _lock ; }
+} ; // class TopicBus
+
+}} ; // namespace
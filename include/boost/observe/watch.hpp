@@ -0,0 +1,157 @@
+/*!
+  @file       watch.hpp
+  @brief      WatchIndex template definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "boost/observe/subject.hpp"
+
+namespace boost { namespace observables {
+
+// what happened to a watched key or index; second argument of a scoped notification
+enum ChangeKind { CHANGE_INSERT = 1, CHANGE_UPDATE = 2, CHANGE_ERASE = 3 } ;
+
+namespace detail {
+
+template <class K, class = void>
+struct is_hashable : std::false_type {} ;
+template <class K>
+struct is_hashable< K, decltype( (void)std::hash<K>()( std::declval<const K &>() )) > : std::true_type {} ;
+
+} // namespace detail
+
+/*!
+  @class WatchIndex< Key, _Pr, _Gate >
+
+  <b>Description:</b>
+  routes a change at one key to the subjects scoped to it, so that a
+  mutation touches only the observers interested in it rather than every
+  observer of the container.
+
+    exact keys   hash map of key -> Subject; an ordered map on _Pr when Key
+                 has no std::hash or _Pr is not std::less, since equality
+                 must then come from _Pr
+    ranges       [lo, hi] inclusive, sorted by lo, with _reach[i] the largest
+                 hi among the first i+1.  a lookup binary-searches the ranges
+                 starting at or before the key, then walks back only while
+                 _reach still covers it
+
+  <b>Notes:</b>
+  owned by a container and guarded by its gate.  subjects live until
+  erased, so a reference returned by key() or range() stays valid while
+  other watches come and go.
+*/
+template <class Key, class _Pr = std::less<Key>, class _Gate = LockFreeMutex>
+class WatchIndex
+{
+  public    :
+    typedef basic_subject< _Gate >   Subject ;
+
+  private   :
+    typedef typename std::conditional< detail::is_hashable<Key>::value && std::is_same< _Pr, std::less<Key> >::value,
+                                       std::unordered_map< Key, Subject >,
+                                       std::map< Key, Subject, _Pr > >::type  _Keys ;
+    struct _Range
+    {
+      Key                            lo ;
+      Key                            hi ;
+      std::unique_ptr<Subject>       subj ;
+    } ;
+
+    _Keys                            _keys ;
+    std::vector<_Range>              _ranges ;
+    std::vector<Key>                 _reach ;
+    _Pr                              _pr ;
+    void                            *_src ;
+
+    bool                             _same( const Key &a, const Key &b ) const { return !_pr( a, b ) && !_pr( b, a ) ; }
+    void                             _reindex()
+                                     {
+                                       std::stable_sort( _ranges.begin(), _ranges.end(), [this]( const _Range &a, const _Range &b ){
+                                         return _pr( a.lo, b.lo ) ;
+                                       }) ;
+                                       _reach.clear() ;
+                                       for (size_t i = 0; i < _ranges.size(); i++)
+                                       {
+                                         if ((i == 0) || _pr( _reach.back(), _ranges[i].hi ))
+                                           _reach.push_back( _ranges[i].hi ) ;
+                                         else
+                                           _reach.push_back( _reach.back() ) ;
+                                       }
+                                     }
+
+  public    :
+                                     WatchIndex( void *src_ = nullptr ) : _src( src_ ) {}
+                                     WatchIndex( const WatchIndex & ) = delete ;
+    WatchIndex                      &operator=( const WatchIndex & ) = delete ;
+
+    Subject                         &key( const Key &k ) { return (*_keys.try_emplace( k, _src ).first).second ; }
+    Subject                         &range( const Key &lo, const Key &hi )
+                                     {
+                                       for (_Range &r : _ranges)
+                                         if (_same( r.lo, lo ) && _same( r.hi, hi ))
+                                           return *r.subj ;
+                                       _ranges.push_back( _Range{ lo, hi, std::unique_ptr<Subject>( new Subject( _src )) } ) ;
+                                       Subject  *s = _ranges.back().subj.get() ;
+                                       _reindex() ;
+                                       return *s ;
+                                     }
+    // drop a watch and its observers; false if there was none
+    bool                             erase_key( const Key &k ) { return _keys.erase( k ) != 0 ; }
+    bool                             erase_range( const Key &lo, const Key &hi )
+                                     {
+                                       for (size_t i = 0; i < _ranges.size(); i++)
+                                       {
+                                         if (_same( _ranges[i].lo, lo ) && _same( _ranges[i].hi, hi ))
+                                         {
+                                           _ranges.erase( _ranges.begin() + i ) ;
+                                           _reindex() ;
+                                           return true ;
+                                         }
+                                       }
+                                       return false ;
+                                     }
+
+    // f( Subject & ) for each watch whose scope contains k
+    template <class F>
+    void                             for_each( const Key &k, F f )
+                                     {
+                                       if (!_keys.empty())
+                                       {
+                                         auto  it = _keys.find( k ) ;
+                                         if (it != _keys.end())
+                                           f( (*it).second ) ;
+                                       }
+                                       if (_ranges.empty())
+                                         return ;
+                                       size_t  j = std::upper_bound( _ranges.begin(), _ranges.end(), k, [this]( const Key &x, const _Range &r ){
+                                                     return _pr( x, r.lo ) ;
+                                                   }) - _ranges.begin() ;
+                                       for (size_t i = j; (i-- > 0) && !_pr( _reach[i], k ); )
+                                       {
+                                         if (!_pr( _ranges[i].hi, k ))
+                                           f( *_ranges[i].subj ) ;
+                                       }
+                                     }
+
+    // access methods
+    bool                             empty() const { return _keys.empty() && _ranges.empty() ; }
+    size_t                           keys() const { return _keys.size() ; }
+    size_t                           ranges() const { return _ranges.size() ; }
+} ; // class WatchIndex
+
+}} ; // namespace
@@ -0,0 +1,246 @@
+/*!
+  @file       workpool.hpp
+  @brief      WorkPool class definition
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boost { namespace observables {
+
+/*!
+  @class WorkPool
+
+  <b>Description:</b>
+  fork-join pool for splitting one large loop across cores, e.g. a subject
+  with tens of thousands of observers.  parallel_for( n, grain, f ) cuts
+  [0, n) into chunks of grain indices, deals them out to the workers' deques
+  and returns once every chunk has run.  the calling thread runs chunks too
+  while it waits, so a pool with no threads still completes every loop, and
+  a chunk may itself call parallel_for without deadlocking the pool.
+
+  <b>Notes:</b>
+  each worker pops its own deque from the back (most recently dealt, still
+  warm) and steals from the front of the others when it runs dry.  the first
+  exception thrown by a chunk is rethrown to the caller once all chunks are
+  done.  a waiting caller may pick up chunks of an unrelated parallel_for.
+*/
+class WorkPool
+{
+  private   :
+    struct _Job
+    {
+      void                           (*run)( void *, size_t, size_t ) ;
+      void                            *body ;
+      std::atomic<size_t>              remaining ;
+      std::atomic<bool>                failed ;
+      std::exception_ptr               error ;
+    } ;
+    struct _Task
+    {
+      _Job                            *job ;
+      size_t                           begin ;
+      size_t                           end ;
+    } ;
+    struct alignas(64) _Queue
+    {
+      std::mutex                       mtx ;
+      std::deque<_Task>                q ;
+    } ;
+
+    std::vector< std::unique_ptr<_Queue> >  _queues ;   // one per worker
+    std::vector<std::thread>           _threads ;
+    std::mutex                         _mtx ;
+    std::condition_variable            _wake ;
+    std::atomic<size_t>                _queued ;
+    std::atomic<size_t>                _deal ;          // round-robin start for callers outside the pool
+    bool                               _running ;
+
+    struct _Worker
+    {
+      const WorkPool                  *pool ;
+      int                              ndx ;
+    } ;
+    static _Worker                    &_tls()
+                                       {
+                                         static thread_local _Worker  w = { nullptr, -1 } ;
+                                         return w ;
+                                       }
+    // worker index of this thread in this pool, else -1
+    int                                _self() const
+                                       {
+                                         const _Worker  &w = _tls() ;
+                                         return (w.pool == this) ? w.ndx : -1 ;
+                                       }
+    template <class F>
+    static void                        _call( void *f, size_t b, size_t e ) { (*(F *)f)( b, e ) ; }
+
+    bool                               _pop( _Queue &qu, bool back, _Task &t )
+                                       {
+                                         std::lock_guard<std::mutex>  lk( qu.mtx ) ;
+                                         if (qu.q.empty())
+                                           return false ;
+                                         if (back)
+                                         {
+                                           t = qu.q.back() ;
+                                           qu.q.pop_back() ;
+                                         }
+                                         else
+                                         {
+                                           t = qu.q.front() ;
+                                           qu.q.pop_front() ;
+                                         }
+                                         _queued.fetch_sub( 1, std::memory_order_relaxed ) ;
+                                         return true ;
+                                       }
+    // own deque first, then steal round the others
+    bool                               _take( int self, _Task &t )
+                                       {
+                                         size_t  n = _queues.size() ;
+                                         if (n == 0)
+                                           return false ;
+                                         if ((self >= 0) && _pop( *_queues[ self ], true, t ))
+                                           return true ;
+                                         size_t  start = (self >= 0) ? (size_t)self + 1 : 0 ;
+                                         for (size_t i = 0; i < n; i++)
+                                         {
+                                           if (_pop( *_queues[ (start + i) % n ], false, t ))
+                                             return true ;
+                                         }
+                                         return false ;
+                                       }
+    static void                        _run( const _Task &t )
+                                       {
+                                         _Job  *j = t.job ;
+                                         try
+                                         {
+                                           if (!j->failed.load( std::memory_order_relaxed ))
+                                             j->run( j->body, t.begin, t.end ) ;
+                                         }
+                                         catch (...)
+                                         {
+                                           if (!j->failed.exchange( true ))
+                                             j->error = std::current_exception() ;
+                                         }
+                                         j->remaining.fetch_sub( 1, std::memory_order_acq_rel ) ;
+                                       }
+    void                               _worker( int self )
+                                       {
+                                         _tls() = _Worker{ this, self } ;
+                                         _Task  t ;
+                                         for (;;)
+                                         {
+                                           if (_take( self, t ))
+                                           {
+                                             _run( t ) ;
+                                             continue ;
+                                           }
+                                           std::unique_lock<std::mutex>  lk( _mtx ) ;
+                                           _wake.wait( lk, [this](){ return !_running || (_queued.load() != 0) ; } ) ;
+                                           if (!_running && (_queued.load() == 0))
+                                             return ;
+                                         }
+                                       }
+
+  public    :
+    // one worker per core besides the caller's
+    static size_t                      default_threads()
+                                       {
+                                         size_t  hc = std::thread::hardware_concurrency() ;
+                                         return (hc > 1) ? hc - 1 : 0 ;
+                                       }
+
+                                       WorkPool( size_t n_threads = default_threads() )
+                                       : _queued( 0 ), _deal( 0 ), _running( true )
+                                       {
+                                         for (size_t i = 0; i < n_threads; i++)
+                                           _queues.emplace_back( new _Queue ) ;
+                                         for (size_t i = 0; i < n_threads; i++)
+                                           _threads.emplace_back( [this, i](){ _worker( (int)i ) ; } ) ;
+                                       }
+                                       WorkPool( const WorkPool & ) = delete ;
+    WorkPool                          &operator=( const WorkPool & ) = delete ;
+                                      ~WorkPool()
+                                       {
+                                         {
+                                           std::lock_guard<std::mutex>  lk( _mtx ) ;
+                                           _running = false ;
+                                         }
+                                         _wake.notify_all() ;
+                                         for (auto &t : _threads)
+                                           t.join() ;
+                                       }
+
+    // runs f( begin, end ) over [0, n) in chunks of grain (0 = about four
+    // chunks per thread, caller included); returns when all have run
+    template <class F>
+    void                               parallel_for( size_t n, size_t grain, F f )
+                                       {
+                                         size_t  workers = _queues.size() ;
+                                         if (grain == 0)
+                                           grain = n / (4 * (workers + 1)) ;
+                                         if (grain == 0)
+                                           grain = 1 ;
+                                         if ((workers == 0) || (n <= grain))
+                                         {
+                                           if (n != 0)
+                                             f( 0, n ) ;
+                                           return ;
+                                         }
+
+                                         _Job  job ;
+                                         size_t  n_chunks = (n + grain - 1) / grain ;
+                                         job.run  = &_call<F> ;
+                                         job.body = &f ;
+                                         job.remaining.store( n_chunks ) ;
+                                         job.failed.store( false ) ;
+
+                                         int     self  = _self() ;
+                                         size_t  first = (self >= 0) ? (size_t)self : _deal.fetch_add( 1, std::memory_order_relaxed ) ;
+                                         for (size_t c = 0; c < n_chunks; c++)
+                                         {
+                                           _Queue  &qu = *_queues[ (first + c) % workers ] ;
+                                           size_t   b  = c * grain ;
+                                           std::lock_guard<std::mutex>  lk( qu.mtx ) ;
+                                           qu.q.push_back( _Task{ &job, b, (b + grain < n) ? b + grain : n } ) ;
+                                         }
+                                         {
+                                           std::lock_guard<std::mutex>  lk( _mtx ) ;
+                                           _queued.fetch_add( n_chunks ) ;
+                                         }
+                                         _wake.notify_all() ;
+
+                                         // help until our chunks are done
+                                         _Task  t ;
+                                         while (job.remaining.load( std::memory_order_acquire ) != 0)
+                                         {
+                                           if (_take( self, t ))
+                                             _run( t ) ;
+                                           else
+                                             std::this_thread::yield() ;
+                                         }
+                                         if (job.failed.load())
+                                           std::rethrow_exception( job.error ) ;
+                                       }
+
+    // access methods
+    size_t                             size() const { return _threads.size() ; }
+    size_t                             queued() const { return _queued.load( std::memory_order_relaxed ) ; }
+} ; // class WorkPool
+
+}} ; // namespace
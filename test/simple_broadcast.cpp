@@ -0,0 +1,66 @@
+/*
+  @file       simple_broadcast.cpp
+  @brief      main file for per-lane broadcast test app 
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "boost/observe/broadcast.hpp"
+
+#define  N_WORKERS          4
+#define  N_OBSERVERS        250      // per worker
+#define  N_TICKS            20000
+
+//-----------------------------------------------------------------------------
+//
+//  one publisher, N_WORKERS consumers.  each worker owns a lane and drains it;
+//  the publisher only touches N_WORKERS inboxes per tick
+//
+std::atomic<uint64_t>   n_calls( 0 ) ;
+std::atomic<bool>       done( false ) ;
+
+int main()
+{
+  boost::observables::BroadcastSubject   ticks( N_WORKERS ) ;
+  std::vector<std::thread>               workers ;
+
+  for (uint32_t w = 0; w < N_WORKERS; w++)
+  {
+    for (uint32_t i = 0; i < N_OBSERVERS; i++)
+    {
+      ticks.install( new boost::observers::Lambda( [](const std::vector<boost::any> &args){ 
+        n_calls.fetch_add( 1, std::memory_order_relaxed ) ; 
+      }), w ) ;
+    }
+  }
+
+  for (uint32_t w = 0; w < N_WORKERS; w++)
+  {
+    workers.emplace_back( [&ticks, w](){ 
+      boost::observables::BroadcastSubject::set_home_lane( w ) ;
+      while (!done || ticks.pending( w ))
+      {
+        if (ticks.drain() == 0)
+          std::this_thread::yield() ;
+      }
+    }) ;
+  }
+
+  for (uint32_t i = 0; i < N_TICKS; i++)
+    ticks.invoke({ (double)i }) ;
+
+  done = true ;
+  for (auto &t : workers)
+    t.join() ;
+
+  printf( "ticks: %ld  observers: %ld  handler calls: %ld (expected %ld) \n", 
+          (long)N_TICKS, (long)ticks.nWatchers(), (long)n_calls.load(), (long)N_TICKS * N_WORKERS * N_OBSERVERS ) ;
+  return 0 ;
+} // :: main
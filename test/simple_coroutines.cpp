@@ -0,0 +1,128 @@
+/*
+  @file       simple_coroutines.cpp
+  @brief      main file for coroutine-awaitable test app (c++20)
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include "boost/observe/numerics.hpp"
+
+using namespace boost ;
+
+//-----------------------------------------------------------------------------
+//
+//  minimal fire-and-forget coroutine type; the library only provides awaitables
+//
+struct Watch
+{
+  struct promise_type
+  {
+    Watch                 get_return_object() { return {} ; }
+    std::suspend_never    initial_suspend() { return {} ; }
+    std::suspend_never    final_suspend() noexcept { return {} ; }
+    void                  return_void() {}
+    void                  unhandled_exception() { throw ; }
+  } ;
+} ; // struct Watch
+
+// keeps its frame after the first suspension so the caller can destroy it
+struct Owned
+{
+  struct promise_type
+  {
+    Owned                 get_return_object() { return { std::coroutine_handle<promise_type>::from_promise( *this ) } ; }
+    std::suspend_never    initial_suspend() { return {} ; }
+    std::suspend_always   final_suspend() noexcept { return {} ; }
+    void                  return_void() {}
+    void                  unhandled_exception() { throw ; }
+  } ;
+  std::coroutine_handle<promise_type>  h ;
+} ; // struct Owned
+
+#define  N_WATCHERS   10000
+
+boost::observables::Numeric< double >   price ;
+uint32_t                                n_alerts = 0 ;
+
+Watch alert_above( double limit )
+{
+  double v = co_await price.when( [limit]( double p ){ return p > limit ; } ) ;
+  if (v > limit)
+    n_alerts++ ;
+} // :: alert_above
+
+// one-shot: resumes once, and its observer is reaped after that dispatch
+Watch await_once( boost::observables::Subject &s, uint32_t &n )
+{
+  co_await s.next() ;
+  n++ ;
+} // :: await_once
+
+Owned await_owned( boost::observables::Subject &s, uint32_t &n )
+{
+  co_await s.next() ;
+  n++ ;
+} // :: await_owned
+
+Owned when_owned( uint32_t &n )
+{
+  co_await price.when( []( double p ){ return p < 0 ; } ) ;
+  n++ ;
+} // :: when_owned
+
+Watch print_ticks( int n )
+{
+  auto ticks = price.changes() ;
+  for (int i = 0; i < n; i++)
+    printf( "tick: %6.2lf \n", co_await ticks.next() ) ;
+} // :: print_ticks
+
+int main()
+{
+  price = 100.0 ;
+
+  for (uint32_t i = 0; i < N_WATCHERS; i++)
+    alert_above( 100.0 + (i % 50) ) ;
+  print_ticks( 3 ) ;
+
+  printf( "suspended watchers: %ld \n", (long)price.valueCB().nWatchers() ) ;
+
+  price = 120.0 ;
+  price = 140.0 ;
+  price = 160.0 ;
+
+  printf( "alerts: %ld of %ld   observers left: %ld \n", 
+          (long)n_alerts, (long)N_WATCHERS, (long)price.valueCB().nWatchers() ) ;
+
+  // a throwing observer must not leave the subject unable to reap
+  boost::observables::Subject  halt ;
+  uint32_t                     n_resumed = 0 ;
+  bool                         thrown    = false ;
+  await_once( halt, n_resumed ) ;
+  await_once( halt, n_resumed ) ;
+  halt << new boost::observers::LambdaPoke( [&thrown](){ if (!thrown) { thrown = true ; throw 1 ; } } ) ;
+  try { halt.invoke() ; } catch (int) {}
+  size_t  n_after_throw = halt.nWatchers() ;
+  await_once( halt, n_resumed ) ;
+  halt.invoke() ;
+  printf( "one-shots resumed %u, observers left %ld after the throw, %ld after the next %s \n", n_resumed,
+          (long)n_after_throw, (long)halt.nWatchers(),
+          ((n_resumed == 3) && (n_after_throw == 1) && (halt.nWatchers() == 1)) ? "" : "FAIL" ) ;
+
+  // coroutines destroyed while suspended: their observers expire, untouched
+  uint32_t  n_cancelled = 0 ;
+  Owned     a = await_owned( halt, n_cancelled ) ;
+  Owned     w = when_owned( n_cancelled ) ;
+  a.h.destroy() ;
+  w.h.destroy() ;
+  halt.invoke() ;
+  price = -1.0 ;
+  printf( "cancelled resumed %u, observers left %ld and %ld %s \n", n_cancelled, (long)halt.nWatchers(),
+          (long)price.valueCB().nWatchers(), ((n_cancelled == 0) && (halt.nWatchers() == 1) && (price.valueCB().nWatchers() == 0)) ? "" : "FAIL" ) ;
+  return 0 ;
+} // :: main
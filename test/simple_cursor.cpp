@@ -0,0 +1,112 @@
+/*
+  @file       simple_cursor.cpp
+  @brief      main file for ChangeCursor test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "boost/observe/numerics.hpp"
+#include "boost/observe/omap.hpp"
+#include "boost/observe/ovector.hpp"
+#include "boost/observe/cursor.hpp"
+
+#define  N_PRICES      10000
+#define  N_FRAMES      1000
+
+//-----------------------------------------------------------------------------
+//
+//  a 60 Hz style render loop over 10k prices, a book and a trade list, polled
+//  instead of observed.  most frames nothing changed and the answer must
+//  come from one pass over the versions
+//
+using namespace boost ;
+
+long us_since( std::chrono::steady_clock::time_point t0 )
+{
+  return (long)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: us_since
+
+int main()
+{
+  std::vector< observables::Numeric<double> >  price( N_PRICES ) ;
+  observables::oMap<int, double>   book ;
+  observables::oVector<int>        trades ;
+  observables::Subject             halt ;
+  observables::ChangeCursor        cursor ;
+
+  for (auto &p : price)
+    cursor.add( p ) ;
+  size_t  i_book   = cursor.add( book ) ;
+  size_t  i_trades = cursor.add( trades ) ;
+  size_t  i_halt   = cursor.add( halt ) ;
+
+  // quiet frames
+  auto  t0 = std::chrono::steady_clock::now() ;
+  int   busy = 0 ;
+  for (int f = 0; f < N_FRAMES; f++)
+    busy += cursor.changed() ? 1 : 0 ;
+  long  us = us_since( t0 ) ;
+  printf( "quiet     %d frames over %ld sources, %d with changes, %.2f ns/source %s \n", N_FRAMES, (long)cursor.size(), busy,
+          1000.0 * us / ((double)N_FRAMES * cursor.size()), (busy == 0) ? "" : "FAIL" ) ;
+
+  // unwatched writes: one of them bumps twice, still reported once
+  price[ 17 ] = 1.5 ;
+  price[ 17 ] += 1.0 ;
+  price[ 4242 ] = 2.0 ;
+  book.insert( 1, 10.0 ) ;
+  halt.invoke() ;
+  std::vector<size_t>  hit ;
+  size_t  n = cursor.poll( [&]( size_t i ){ hit.push_back( i ) ; } ) ;
+  printf( "poll      %ld changed:", (long)n ) ;
+  for (size_t i : hit)
+    printf( " %ld", (long)i ) ;
+  bool  ok = (n == 4) && (hit[0] == 17) && (hit[1] == 4242) && (hit[2] == i_book) && (hit[3] == i_halt) ;
+  printf( " %s \n", ok ? "" : "FAIL" ) ;
+  printf( "poll      again: %ld changed %s \n", (long)cursor.poll( []( size_t ){} ), cursor.changed() ? "FAIL" : "" ) ;
+
+  // watched writes count the same; an unchanged assignment does not
+  price[ 3 ] << new observers::Lambda( []( const std::vector<boost::any> & ){} ) ;
+  price[ 3 ] = 7.0 ;
+  price[ 5 ] = price[ 5 ] ;
+  trades.push_back( 1 ) ;
+  trades.set( 0, 2 ) ;
+  n = cursor.poll( [&]( size_t i ){ hit.push_back( i ) ; } ) ;
+  printf( "poll      watched price and trades: %ld changed, trades at v%ld %s \n", (long)n, (long)trades.version(),
+          ((n == 2) && (hit.back() == i_trades) && (trades.version() == 2)) ? "" : "FAIL" ) ;
+
+  // the writer's side: an unwatched Numeric with and without a poller
+  observables::Numeric<double>  a, b ;
+  b.version() ;
+  t0 = std::chrono::steady_clock::now() ;
+  for (int i = 1; i <= 10000000; i++)
+    a = (double)i ;
+  long  us_a = us_since( t0 ) ;
+  t0 = std::chrono::steady_clock::now() ;
+  for (int i = 1; i <= 10000000; i++)
+    b = (double)i ;
+  long  us_b = us_since( t0 ) ;
+  printf( "writer    10M unwatched writes: %ld us unpolled, %ld us polled, b at v%ld %s \n", us_a, us_b, (long)b.version(),
+          (b.version() == 10000000) ? "" : "FAIL" ) ;
+
+  // two writers at once: every write moves the version
+  observables::Numeric<double>  c ;
+  c.version() ;
+  std::thread  t( [&c](){
+    for (int i = 1; i <= 1000000; i++)
+      c = (double)i ;
+  }) ;
+  for (int i = 1; i <= 1000000; i++)
+    c = (double)-i ;
+  t.join() ;
+  printf( "writers   2 x 1M unwatched writes, c at v%ld %s \n", (long)c.version(), (c.version() == 2000000) ? "" : "FAIL" ) ;
+  printf( "sizeof    Subject %d, Numeric<double> %d \n", (int)sizeof(observables::Subject), (int)sizeof(observables::Numeric<double>) ) ;
+  return 0 ;
+} // :: main
@@ -10,6 +10,8 @@
   file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 */
 #include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
 #include "boost/observe/eventmap.hpp"
 #include <boost/any.hpp>
 #include <vector> 
@@ -129,6 +131,51 @@ void test_string_events()
 
 } // :: test_string_events
 
+void test_batch_events()
+{
+  printf( "--[  batch event test  ]--\n" ) ;
+
+  // a drained message queue: 20000 events over 7 ids plus some nobody handles
+  Events                        evts ;
+  std::vector<Events::Event>    queue ;
+  std::vector<uint32_t>         last( FM_MOUSEMOVE + 1, 0 ) ;
+  uint32_t                      n_hit = 0, n_default = 0, n_order = 0 ;
+  for (uint32_t id = FM_LBUTTONDN; id <= FM_MOUSEMOVE; id++)
+  {
+    evts.get( id ) << new observers::Lambda( [&]( const std::vector<boost::any> &args ){
+      uint32_t  id  = boost::any_cast<uint32_t>( args[0] ) ;
+      uint32_t  seq = boost::any_cast<uint32_t>( args[1] ) ;
+      if (seq < last[ id ])
+        n_order++ ;
+      last[ id ] = seq ;
+      n_hit++ ;
+    }) ;
+  }
+  evts.get_default() << new observers::Lambda( [&]( const std::vector<boost::any> & ){ n_default++ ; } ) ;
+
+  srand( 3 ) ;
+  for (uint32_t seq = 1; seq <= 20000; seq++)
+    queue.push_back( Events::Event{ (uint32_t)(rand() % (FM_MOUSEMOVE + 3)), { seq, (uint32_t)0x0001 } } ) ;
+
+  auto  t0 = std::chrono::steady_clock::now() ;
+  for (auto &e : queue)
+    evts.invoke( e.id, e.args ) ;
+  auto  us_one = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+
+  uint32_t  one_hit = n_hit, one_default = n_default ;
+  n_hit = n_default = 0 ;
+  std::fill( last.begin(), last.end(), 0 ) ;
+  t0 = std::chrono::steady_clock::now() ;
+  size_t  hit = evts.invoke_batch( queue ) ;
+  auto  us_batch = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+
+  printf( "one at a time  %ld us   handled %u, default %u \n", (long)us_one, one_hit, one_default ) ;
+  printf( "invoke_batch   %ld us   handled %u (returned %ld), default %u, out of order %u %s \n", (long)us_batch, n_hit, (long)hit,
+          n_default, n_order, ((n_hit == one_hit) && (hit == n_hit) && (n_default == one_default) && (n_order == 0)) ? "" : "FAIL" ) ;
+  printf( "\n" ) ;
+
+} // :: test_batch_events
+
 //-----------------------------------------------------------------------------
 //
 //
@@ -139,6 +186,8 @@ int main()
 
   test_fake_window_events() ;
 
+  test_batch_events() ;
+
   return 0 ;
 } // :: main
 
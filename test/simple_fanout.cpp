@@ -0,0 +1,97 @@
+/*
+  @file       simple_fanout.cpp
+  @brief      main file for the parallel fan-out test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "boost/observe/numerics.hpp"
+
+#define  N_POSITIONS   50000
+#define  N_TICKS       200
+
+//-----------------------------------------------------------------------------
+//
+//  one price with 50k position observers, marked parallel-safe, plus a book
+//  total that is not.  each tick is timed serially and then fanned out over
+//  a WorkPool; the results must agree
+//
+using namespace boost ;
+
+class PositionEntry
+{
+  public :
+    double      _qty ;
+    double      _value ;
+
+                PositionEntry( double qty ) : _qty( qty ), _value( 0 ) {}
+
+    void        onPrice( const std::vector<boost::any> &args )
+                {
+                  double  px = any_cast<double>( args[0] ) ;
+                  _value = _qty * px * exp( -1e-9 * px ) ;    // some per-position work
+                }
+} ; // class PositionEntry
+
+double run( observables::WorkPool *pool, const char *name )
+{
+  observables::Numeric<double>   price ;
+  std::vector<PositionEntry>     book ;
+  double                         total = 0 ;
+
+  book.reserve( N_POSITIONS ) ;
+  for (int i = 0; i < N_POSITIONS; i++)
+  {
+    book.emplace_back( (double)(i % 100 + 1) ) ;
+    price << (new observers::MemberFunc<PositionEntry>( &book.back(), &PositionEntry::onPrice ))->set_parallel_safe() ;
+  }
+  // not parallel-safe: runs on the invoking thread, after every position
+  price << new observers::Lambda( [&]( const std::vector<boost::any> & ){
+    total = 0 ;
+    for (auto &p : book)
+      total += p._value ;
+  }) ;
+  if (pool)
+    price.valueCB().set_parallel( 1000, pool ) ;
+
+  auto  t0 = std::chrono::steady_clock::now() ;
+  for (int i = 1; i <= N_TICKS; i++)
+    price = 100.0 + i * 0.01 ;
+  auto  us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+
+  printf( "%-10s threads %d   %.1f us/tick   total %.4f \n", name, pool ? (int)pool->size() : 0, (double)us / N_TICKS, total ) ;
+  return total ;
+} // :: run
+
+int main()
+{
+  observables::WorkPool  pool( observables::WorkPool::default_threads() ? observables::WorkPool::default_threads() : 2 ) ;
+
+  double  a = run( nullptr, "serial" ) ;
+  double  b = run( &pool, "parallel" ) ;
+  printf( "%s \n", (a == b) ? "totals match" : "FAIL: totals differ" ) ;
+
+  // a throwing parallel observer reaches the caller once the fan-out is joined
+  observables::Numeric<int>  x ;
+  for (int i = 0; i < 2000; i++)
+    x << (new observers::Lambda( [i]( const std::vector<boost::any> & ){ if (i == 1234) throw i ; } ))->set_parallel_safe() ;
+  x.valueCB().set_parallel( 100, &pool ) ;
+  try
+  {
+    x = 1 ;
+    printf( "FAIL: exception lost \n" ) ;
+  }
+  catch (int i)
+  {
+    printf( "caught %d from a worker \n", i ) ;
+  }
+  return 0 ;
+} // :: main
@@ -0,0 +1,115 @@
+/*
+  @file       simple_gates.cpp
+  @brief      main file for the gate (threading policy) test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "boost/observe/numerics.hpp"
+#include "boost/observe/eventmap.hpp"
+#include "boost/observe/omap.hpp"
+#include "boost/observe/ovector.hpp"
+
+#define  N_UPDATES     10000000
+
+//-----------------------------------------------------------------------------
+//
+//  the same watched counter under each gate: the shared spin lock, the
+//  single-threaded NullMutex and a user-supplied std::recursive_mutex.  then
+//  per-thread containers and an EventMap on NullMutex, and a subject whose
+//  observers come and go on one thread while another invokes it
+//
+using namespace boost ;
+
+template <class _Gate>
+void test_numeric( const char *name )
+{
+  observables::Numeric< int64_t, _Gate >  x ;
+  int64_t                                 n_seen = 0 ;
+
+  x << new observers::Lambda( [&n_seen]( const std::vector<boost::any> & ){ n_seen++ ; } ) ;
+
+  auto  t0 = std::chrono::steady_clock::now() ;
+  for (int64_t i = 0; i < N_UPDATES; i++)
+    x += 1 ;
+  auto  ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+
+  printf( "%-16s x = %ld   %ld notifications   %.2f ns/update \n", name, (long)(int64_t)x, (long)n_seen,
+          (double)ns / N_UPDATES ) ;
+} // :: test_numeric
+
+void test_containers()
+{
+  typedef observables::NullMutex  Local ;
+
+  observables::oMap< int, double, std::less<int>, Local >  m ;
+  observables::oVector< double, Local >                    v ;
+  observables::EventMap< int, Local >                      evts ;
+  int                                                      n_ins = 0, n_evt = 0 ;
+
+  m.postInsertCB() << new observers::Lambda( [&n_ins]( const std::vector<boost::any> & ){ n_ins++ ; } ) ;
+  v.postInsertCB() << new observers::Lambda( [&n_ins]( const std::vector<boost::any> & ){ n_ins++ ; } ) ;
+  evts.get( 7 ) << new observers::Lambda( [&n_evt]( const std::vector<boost::any> &args ){
+    n_evt += any_cast<int>( args[0] ) ;
+  }) ;
+
+  for (int i = 0; i < 100; i++)
+  {
+    m.insert( i, i * 0.5 ) ;
+    v.push_back( i * 0.5 ) ;
+    evts.invoke( 7 ) ;
+  }
+  printf( "containers       map %d, vector %d, %d inserts seen, event sum %d \n", (int)m.size(), (int)v.size(), n_ins, n_evt ) ;
+  printf( "sizes            Subject %d, basic_subject<NullMutex> %d, Numeric<double> %d, Numeric<double,NullMutex> %d \n",
+          (int)sizeof(observables::Subject), (int)sizeof(observables::basic_subject<Local>),
+          (int)sizeof(observables::Numeric<double>), (int)sizeof(observables::Numeric<double,Local>) ) ;
+} // :: test_containers
+
+void test_churn()
+{
+  observables::Subject   s ;
+  std::atomic<long>      n_seen( 0 ) ;
+  std::atomic<bool>      done( false ) ;
+  observers::Lambda      a( [&n_seen]( const std::vector<boost::any> & ){ n_seen++ ; } ) ;
+  observers::Lambda      b( [&n_seen]( const std::vector<boost::any> & ){ n_seen++ ; } ) ;
+
+  // one observer keeps the subject inline, two need its out-of-line state
+  std::thread  t( [&](){
+    for (int i = 0; i < 200000; i++)
+    {
+      s.install( &a ) ;
+      s.install( &b ) ;
+      s.remove( &a ) ;
+      s.remove( &b ) ;
+    }
+    done = true ;
+  }) ;
+  long  n_invoked = 0 ;
+  while (!done)
+  {
+    s.invoke() ;
+    n_invoked++ ;
+  }
+  t.join() ;
+  printf( "churn            %ld invokes during 200k install/remove rounds, %ld notifications, %d watchers left %s \n",
+          n_invoked, (long)n_seen, (int)s.nWatchers(), (s.nWatchers() == 0) ? "" : "FAIL" ) ;
+} // :: test_churn
+
+int main()
+{
+  test_numeric< observables::LockFreeMutex >( "LockFreeMutex" ) ;
+  test_numeric< observables::NullMutex >( "NullMutex" ) ;
+  test_numeric< std::recursive_mutex >( "recursive_mutex" ) ;
+  test_containers() ;
+  test_churn() ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,72 @@
+/*
+  @file       simple_graph.cpp
+  @brief      main file for observer-graph export test app 
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  build with  -DBOOST_OBSERVERS_REGISTRY -DBOOST_OBSERVERS_INSTRUMENT
+*/
+#include <stdio.h>
+#include <iostream>
+#include "boost/observe/numerics.hpp"
+#include "boost/observe/graph.hpp"
+
+//-----------------------------------------------------------------------------
+//
+//  price  -->  Position::on_price  -->  Position::value  -->  Book::on_value  -->  Book::total
+//
+class Book
+{
+  public  :
+    boost::observables::Numeric< double >   total ;
+
+    void               on_value( const std::vector<boost::any> &args )
+                       {
+                         total += boost::any_cast<double>( args[0] ) - boost::any_cast<double>( args[1] ) ;
+                       }
+} ; // class Book
+
+class Position
+{
+  public  :
+    double                                  qty ;
+    boost::observables::Numeric< double >   value ;
+
+                       Position( boost::observables::Numeric< double > &price, Book &book, double q ) 
+                       : qty( q )
+                       {
+                         price << new boost::observers::MemberFunc<Position>( this, &Position::on_price ) ;
+                         value << new boost::observers::MemberFunc<Book>( &book, &Book::on_value ) ;
+                       }
+    void               on_price( const std::vector<boost::any> &args )
+                       {
+                         value = qty * boost::any_cast<double>( args[0] ) ;
+                       }
+} ; // class Position
+
+int main()
+{
+  boost::observables::Numeric< double >   price ;
+  Book                                    book ;
+  Position                                p1( price, book, 100 ) ;
+  Position                                p2( price, book, 300 ) ;
+
+  for (int i = 1; i <= 10; i++)
+    price = 50.0 + i ;
+
+  boost::observables::ObserverGraph  g ;
+  g.capture() ;
+
+  printf( "book total: %.2lf \n", (double)book.total ) ;
+  printf( "largest fan-out: %ld observers \n\n", (long)g.top_fanout( 1 )[0].n_watchers ) ;
+  g.write_dot( std::cout ) ;
+  printf( "\n" ) ;
+  g.write_json( std::cout ) ;
+
+  return 0 ;
+} // :: main
@@ -0,0 +1,105 @@
+/*
+  @file       simple_instrument.cpp
+  @brief      main file for the instrumentation test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  instrumentation is compiled in here whatever the build flags
+*/
+#ifndef BOOST_OBSERVERS_INSTRUMENT
+#  define  BOOST_OBSERVERS_INSTRUMENT
+#endif
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include "boost/observe/subject.hpp"
+
+//-----------------------------------------------------------------------------
+//
+//  the histogram's percentile math against known inputs, a subject's own
+//  counters, and the slow-observer callback firing for the one slow call
+//
+using namespace boost ;
+
+typedef observables::LatencyHistogram  Histogram ;
+
+// percentiles report the lower edge of a bucket: within 1/SUB below the truth
+bool near( uint64_t got, uint64_t want )
+{
+  return (got <= want) && ((double)(want - got) <= (double)want / (double)Histogram::SUB) ;
+} // :: near
+
+void test_histogram()
+{
+  Histogram  h ;
+  bool       empty = (h.percentile( 50 ) == 0) && (h.count() == 0) && (h.mean() == 0) ;
+
+  for (uint64_t v = 1; v <= 1000; v++)
+    h.record( v ) ;
+  printf( "histogram  n %ld  mean %.1f  max %ld  p0 %ld  p50 %ld  p90 %ld  p99 %ld  p100 %ld %s \n", (long)h.count(), h.mean(),
+          (long)h.max(), (long)h.percentile( 0 ), (long)h.percentile( 50 ), (long)h.percentile( 90 ), (long)h.percentile( 99 ),
+          (long)h.percentile( 100 ),
+          (empty && (h.count() == 1000) && (h.total() == 500500) && (h.max() == 1000) && (h.percentile( 0 ) == 1)
+           && near( h.percentile( 50 ), 500 ) && near( h.percentile( 90 ), 900 ) && near( h.percentile( 99 ), 990 )
+           && near( h.percentile( 100 ), 1000 )) ? "" : "FAIL" ) ;
+
+  // small values are exact; huge ones clamp into the last bucket
+  Histogram  s ;
+  for (uint64_t v = 0; v < Histogram::SUB; v++)
+    s.record( v ) ;
+  bool  exact = true ;
+  for (uint64_t v = 0; v < Histogram::SUB; v++)
+    exact = exact && (s.percentile( 100.0 * (v + 1) / (double)Histogram::SUB ) == v) ;
+  s.record( UINT64_MAX ) ;
+  printf( "histogram  exact below %d: %s, clamped max %s %s \n", (int)Histogram::SUB, exact ? "yes" : "no",
+          (s.max() == UINT64_MAX) ? "kept" : "lost", (exact && (s.max() == UINT64_MAX) && (s.percentile( 100 ) > 0)) ? "" : "FAIL" ) ;
+
+  h.reset() ;
+  printf( "histogram  after reset n %ld %s \n", (long)h.count(), ((h.count() == 0) && (h.percentile( 99 ) == 0)) ? "" : "FAIL" ) ;
+} // :: test_histogram
+
+void test_subject()
+{
+  observables::Subject         s ;
+  observers::Observer         *fast = nullptr, *slow = nullptr, *reported = nullptr ;
+  int                          n_slow = 0, n_calls = 0 ;
+
+  fast = s.install( new observers::Lambda( []( const std::vector<boost::any> & ){} )) ;
+  slow = s.install( new observers::Lambda( [&n_calls]( const std::vector<boost::any> & ){
+    if (++n_calls == 50)
+      std::this_thread::sleep_for( std::chrono::milliseconds( 5 )) ;
+  })) ;
+  observables::Instrument::set_slow_observer( 2000000, [&]( observables::Subject *, observers::Observer *o, uint64_t ticks ){
+    n_slow++ ;
+    reported = o ;
+    printf( "slow       %.2f ms in one observer \n", observables::Instrument::to_nsec( ticks ) / 1.0e6 ) ;
+  }) ;
+
+  bool  none = (s.stats() == nullptr) ;
+  for (int i = 0; i < 100; i++)
+    s.invoke() ;
+  observables::Instrument::set_slow_observer( 0, nullptr ) ;
+
+  const observables::SubjectStats  *st = s.stats() ;
+  double  p100_ms = observables::Instrument::to_nsec( st->latency.percentile( 100 )) / 1.0e6 ;
+  printf( "subject    invokes %ld, timed %ld, p50 %.0f ns, p100 %.2f ms, observers ran %ld / %ld %s \n", (long)st->invokes,
+          (long)st->latency.count(), observables::Instrument::to_nsec( st->latency.percentile( 50 )), p100_ms,
+          (long)fast->nInvokes(), (long)slow->nInvokes(),
+          (none && (st->invokes == 100) && (st->latency.count() == 100) && (p100_ms >= 4.0) && (fast->nInvokes() == 100)
+           && (slow->nInvokes() == 100)) ? "" : "FAIL" ) ;
+  printf( "slow       %d report(s), for the slow observer: %s %s \n", n_slow, (reported == slow) ? "yes" : "no",
+          ((n_slow == 1) && (reported == slow)) ? "" : "FAIL" ) ;
+} // :: test_subject
+
+int main()
+{
+  test_histogram() ;
+  test_subject() ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,108 @@
+/*
+  @file       simple_journal.cpp
+  @brief      main file for journal record/replay test app 
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include "boost/observe/journal.hpp"
+
+#define  N_STOCKS      16
+#define  N_TICKS       1000000
+#define  JOURNAL_FILE  "simple_journal.bin"
+
+//-----------------------------------------------------------------------------
+//
+//  record a run of random ticks into N_STOCKS prices, then replay the file into
+//  a fresh set of prices and check that both ended in the same state.  then
+//  the edges: taps outliving their journal, a thread writing two journals,
+//  and a record larger than a thread buffer
+//
+typedef  boost::observables::Numeric< double >   Price ;
+
+double elapsed( std::chrono::steady_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: elapsed
+
+int main()
+{
+  Price     live  [ N_STOCKS ] ;
+  Price     replay[ N_STOCKS ] ;
+  uint32_t  n_changes = 0 ;
+
+  {
+    boost::observables::Journal  j( JOURNAL_FILE, (uint64_t)N_TICKS * 32 + (1 << 20) ) ;
+    for (uint32_t i = 0; i < N_STOCKS; i++)
+      j.tap( live[i], i ) ;
+
+    auto t0 = std::chrono::steady_clock::now() ;
+    for (uint32_t i = 0; i < N_TICKS; i++)
+      live[ rand() % N_STOCKS ] = 50.0 + (rand() % 10000) / 100.0 ;
+    j.close() ;
+    printf( "recorded  %ld ticks in %.3lf s   (%ld bytes, %ld dropped) \n", 
+            (long)N_TICKS, elapsed( t0 ), (long)j.used(), (long)j.dropped() ) ;
+  }
+
+  for (uint32_t i = 0; i < N_STOCKS; i++)
+    replay[i] << new boost::observers::LambdaPoke( [&n_changes](){ n_changes++ ; } ) ;
+
+  boost::observables::JournalReplayer  r( JOURNAL_FILE ) ;
+  for (uint32_t i = 0; i < N_STOCKS; i++)
+    r.bind( i, replay[i] ) ;
+
+  auto      t0 = std::chrono::steady_clock::now() ;
+  uint64_t  n  = r.replay() ;
+  double    dt = elapsed( t0 ) ;
+  printf( "replayed  %ld records in %.3lf s   (%.1lf M/s, %ld notifications) \n", 
+          (long)n, dt, (double)n / dt / 1.0e6, (long)n_changes ) ;
+
+  uint32_t  n_bad = 0 ;
+  for (uint32_t i = 0; i < N_STOCKS; i++)
+    if ((double)live[i] != (double)replay[i])
+      n_bad++ ;
+  printf( "%s \n", (n_bad == 0) ? "final state matches" : "FAIL.  final state differs" ) ;
+
+  remove( JOURNAL_FILE ) ;
+
+  // the journal is gone: the taps expire on the next write instead of recording
+  live[0] = 1.0 ;
+  live[1] = 1.0 ;
+  printf( "taps      %d watchers left on a price after its journal closed %s \n", (int)live[0].valueCB().nWatchers(),
+          (live[0].valueCB().nWatchers() == 0) ? "" : "FAIL" ) ;
+
+  // one thread alternating between journals, and an oversized record
+  {
+    boost::observables::Journal  a( "simple_journal_a.bin", 1 << 20 ) ;
+    boost::observables::Journal  b( "simple_journal_b.bin", 1 << 20 ) ;
+    uint64_t                     a0 = a.used(), b0 = b.used() ;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+      a.record( 0, boost::observables::JOP_VALUE, &i, sizeof(i) ) ;
+      b.record( 0, boost::observables::JOP_VALUE, &i, sizeof(i) ) ;
+    }
+    std::vector<char>  big( 65535, 'x' ) ;
+    b.record( 1, boost::observables::JOP_ARGS, big.data(), (uint16_t)big.size() ) ;
+    a.close() ;
+    b.close() ;
+    printf( "journals  a %ld bytes, b %ld bytes, %ld dropped %s \n", (long)(a.used() - a0), (long)(b.used() - b0),
+            (long)(a.dropped() + b.dropped()),
+            ((a.used() - a0 == 20000 * 24) && (b.used() - b0 == 20000 * 24 + 16 + 65536) && (a.dropped() + b.dropped() == 0)) ? "" : "FAIL" ) ;
+
+    boost::observables::JournalReplayer  rb( "simple_journal_b.bin" ) ;
+    size_t  n_big = 0 ;
+    rb.bind( 1, [&n_big]( const boost::observables::JournalRecord &r, const char * ) { n_big = r.len ; } ) ;
+    uint64_t  n_b = rb.replay() ;
+    printf( "replayed  %ld records of b, oversized record %ld bytes %s \n", (long)n_b, (long)n_big,
+            ((n_b == 20001) && (n_big == 65535)) ? "" : "FAIL" ) ;
+  }
+  remove( "simple_journal_a.bin" ) ;
+  remove( "simple_journal_b.bin" ) ;
+  return 0 ;
+} // :: main
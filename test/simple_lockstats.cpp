@@ -0,0 +1,103 @@
+/*
+  @file       simple_lockstats.cpp
+  @brief      main file for the LockFreeMutex contention statistics test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+  lock statistics are compiled in here whatever the build flags
+*/
+#ifndef BOOST_OBSERVERS_LOCK_STATS
+#  define  BOOST_OBSERVERS_LOCK_STATS
+#endif
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <boost/thread/lock_guard.hpp>
+#include "boost/observe/lfmutex.hpp"
+
+//-----------------------------------------------------------------------------
+//
+//  counts on an uncontended gate, one outermost acquire per recursive hold,
+//  the sample rate, a forced contention, and per-name sums that outlive the
+//  gates they came from
+//
+using namespace boost ;
+
+typedef observables::LockFreeMutex  Gate ;
+
+void lock_n( Gate &g, int n )
+{
+  for (int i = 0; i < n; i++)
+  {
+    g.lock() ;
+    g.unlock() ;
+  }
+} // :: lock_n
+
+int main()
+{
+  Gate::set_sample_rate( 1 ) ;
+  Gate  a ;
+  lock_n( a, 1000 ) ;
+  a.lock() ;
+  a.lock() ;                 // recursive: still one acquisition
+  a.unlock() ;
+  a.unlock() ;
+  observables::LockStats  s = a.stats() ;
+  printf( "plain      acquisitions %ld, contended %ld, spins %ld, samples %ld %s \n", (long)s.acquisitions, (long)s.contended,
+          (long)s.spins, (long)s.samples,
+          ((s.acquisitions == 1001) && (s.contended == 0) && (s.spins == 0) && (s.samples == 1001)) ? "" : "FAIL" ) ;
+
+  // one acquire in ten is timed; none with a rate of 0
+  Gate  b, c ;
+  Gate::set_sample_rate( 10 ) ;
+  lock_n( b, 1000 ) ;
+  Gate::set_sample_rate( 0 ) ;
+  lock_n( c, 1000 ) ;
+  Gate::set_sample_rate( 1 ) ;
+  printf( "sampling   1 in 10: %ld of %ld timed, off: %ld of %ld timed %s \n", (long)b.stats().samples, (long)b.stats().acquisitions,
+          (long)c.stats().samples, (long)c.stats().acquisitions,
+          ((b.stats().samples == 100) && (b.stats().acquisitions == 1000) && (c.stats().samples == 0) && (c.stats().acquisitions == 1000))
+          ? "" : "FAIL" ) ;
+
+  // another thread spins while this one holds the gate
+  Gate               d ;
+  std::atomic<bool>  waiting( false ) ;
+  d.lock() ;
+  std::thread  t( [&](){
+    waiting = true ;
+    d.lock() ;
+    d.unlock() ;
+  }) ;
+  while (!waiting)
+    std::this_thread::yield() ;
+  std::this_thread::sleep_for( std::chrono::milliseconds( 20 )) ;
+  d.unlock() ;
+  t.join() ;
+  s = d.stats() ;
+  printf( "contention acquisitions %ld, contended %ld, spins %ld, waited %.1f ms, longest hold %.1f ms %s \n", (long)s.acquisitions,
+          (long)s.contended, (long)s.spins, observables::Instrument::to_nsec( s.wait_ticks ) / 1.0e6,
+          observables::Instrument::to_nsec( s.max_hold_ticks ) / 1.0e6,
+          ((s.acquisitions == 2) && (s.contended == 1) && (s.spins > 0) && (s.wait_ticks > 0) && (s.max_hold_ticks > 0)) ? "" : "FAIL" ) ;
+
+  // gates sharing a name are summed, and a destroyed gate's figures are kept
+  {
+    Gate  e, f ;
+    e.set_name( "simple_lockstats::gate" ) ;
+    f.set_name( "simple_lockstats::gate" ) ;
+    lock_n( e, 300 ) ;
+    lock_n( f, 200 ) ;
+  }
+  Gate  g ;
+  g.set_name( "simple_lockstats::gate" ) ;
+  lock_n( g, 50 ) ;
+  uint64_t  n = observables::LockStatsRegistry::instance().by_name()[ "simple_lockstats::gate" ].acquisitions ;
+  printf( "registry   %ld acquisitions under one name %s \n", (long)n, (n == 550) ? "" : "FAIL" ) ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,127 @@
+/*
+  @file       simple_mailbox.cpp
+  @brief      main file for bounded asynchronous observer test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include "boost/observe/mailbox.hpp"
+
+#define  N_SYMBOLS     8
+#define  N_TICKS       10000
+#define  MAILBOX_SIZE  64
+
+//-----------------------------------------------------------------------------
+//
+//  a market-data subject publishes { symbol, price } faster than a 'gui'
+//  observer can draw.  each policy is run with the gui pumped only at the end,
+//  then once more with a worker thread and a blocked publisher
+//
+using namespace boost ;
+
+const char *policy_name( observers::OverflowPolicy p )
+{
+  switch (p)
+  {
+    case observers::OVERFLOW_BLOCK       : return "block" ;
+    case observers::OVERFLOW_DROP_OLDEST : return "drop-oldest" ;
+    case observers::OVERFLOW_DROP_NEWEST : return "drop-newest" ;
+    default                              : return "conflate" ;
+  }
+} // :: policy_name
+
+void test_policy( observers::OverflowPolicy p )
+{
+  observables::Subject  feed ;
+  uint32_t              drawn   = 0 ;
+  int64_t               highest = 0 ;
+  double                last[ N_SYMBOLS ] = { 0 } ;
+
+  observers::AsyncObserver  *gui = new observers::AsyncObserver(
+    new observers::Lambda( [&]( const std::vector<boost::any> &args ) {
+      last[ any_cast<uint32_t>( args[0] ) ] = any_cast<double>( args[1] ) ;
+      drawn++ ;
+    }), MAILBOX_SIZE, p,
+    []( const std::vector<boost::any> &args ){ return (uint64_t)any_cast<uint32_t>( args[0] ) ; } ) ;
+  gui->depth() << new observers::Lambda( [&highest]( const std::vector<boost::any> &args ) {
+    highest = std::max( highest, any_cast<int64_t>( args[0] )) ;
+  }) ;
+  feed << gui ;
+
+  for (uint32_t i = 0; i < N_TICKS; i++)
+    feed.invoke({ i % N_SYMBOLS, (double)i }) ;
+  gui->pump() ;
+
+  bool  latest = true ;
+  for (uint32_t s = 0; s < N_SYMBOLS; s++)
+    latest = latest && (last[s] == (double)(N_TICKS - N_SYMBOLS + s)) ;
+  printf( "%-12s drawn %5ld  dropped %5ld  max depth %3ld  latest %s \n", policy_name( p ),
+          (long)drawn, (long)(uint64_t)gui->drops(), (long)highest, latest ? "yes" : "no" ) ;
+} // :: test_policy
+
+void test_blocking_worker()
+{
+  observables::Subject  feed ;
+  std::atomic<uint32_t> drawn( 0 ) ;
+
+  observers::AsyncObserver  *gui = new observers::AsyncObserver(
+    new observers::Lambda( [&drawn]( const std::vector<boost::any> & ) {
+      std::this_thread::sleep_for( std::chrono::microseconds( 10 )) ;
+      drawn++ ;
+    }), MAILBOX_SIZE, observers::OVERFLOW_BLOCK ) ;
+  feed << gui ;
+  gui->start() ;
+
+  for (uint32_t i = 0; i < N_TICKS / 10; i++)
+    feed.invoke({ i % N_SYMBOLS, (double)i }) ;
+  gui->stop() ;
+  printf( "worker       drawn %5ld of %ld, depth never above %ld, %ld at stop %s \n", (long)drawn.load(), (long)(N_TICKS / 10),
+          (long)gui->capacity(), (long)(int64_t)gui->depth(), ((int64_t)gui->depth() == 0) ? "" : "FAIL" ) ;
+
+  // stopped: publishers fill the mailbox once, then drop instead of waiting
+  for (uint32_t i = 0; i < 2 * MAILBOX_SIZE; i++)
+    feed.invoke({ i % N_SYMBOLS, (double)i }) ;
+  printf( "stopped      depth %ld, dropped %ld %s \n", (long)(int64_t)gui->depth(), (long)(uint64_t)gui->drops(),
+          (((int64_t)gui->depth() == MAILBOX_SIZE) && ((uint64_t)gui->drops() == MAILBOX_SIZE)) ? "" : "FAIL" ) ;
+} // :: test_blocking_worker
+
+// notifications without arguments conflate under key 0 like any other
+void test_conflate_argless()
+{
+  observables::Subject  feed ;
+  uint32_t              n_bare = 0, n_args = 0 ;
+
+  observers::AsyncObserver  *gui = new observers::AsyncObserver(
+    new observers::Lambda( [&]( const std::vector<boost::any> &args ) {
+      if (args.empty())
+        n_bare++ ;
+      else
+        n_args++ ;
+    }), MAILBOX_SIZE, observers::OVERFLOW_CONFLATE,
+    []( const std::vector<boost::any> &args ){ return (uint64_t)any_cast<uint32_t>( args[0] ) ; } ) ;
+  feed << gui ;
+
+  feed.invoke() ;
+  feed.invoke() ;
+  feed.invoke({ (uint32_t)1, 1.0 }) ;
+  gui->pump() ;
+  printf( "argless      delivered %u bare, %u with args, dropped %ld %s \n", n_bare, n_args, (long)(uint64_t)gui->drops(),
+          ((n_bare == 1) && (n_args == 1) && ((uint64_t)gui->drops() == 1)) ? "" : "FAIL" ) ;
+} // :: test_conflate_argless
+
+int main()
+{
+  test_policy( observers::OVERFLOW_DROP_OLDEST ) ;
+  test_policy( observers::OVERFLOW_DROP_NEWEST ) ;
+  test_policy( observers::OVERFLOW_CONFLATE ) ;
+  test_blocking_worker() ;
+  test_conflate_argless() ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,210 @@
+/*
+  @file       simple_mvcc.cpp
+  @brief      main file for oMap / oVector snapshot test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <boost/thread/lock_guard.hpp>
+#include "boost/observe/omap.hpp"
+#include "boost/observe/ovector.hpp"
+
+#define  N_POSITIONS   100000
+#define  N_BATCHES     20000
+
+//-----------------------------------------------------------------------------
+//
+//  a position book that a tick thread rebalances in batches: each batch
+//  moves an amount between two positions under the book's gate, so the book
+//  total never changes.  a report thread sums snapshots without locking; a
+//  torn batch would show as a wrong total
+//
+using namespace boost ;
+
+typedef observables::oMap< int, double >  Book ;
+
+template <class S>
+bool same( const S &snap, const std::map<int, double> &live )
+{
+  if (snap.size() != live.size())
+    return false ;
+  auto  it = live.begin() ;
+  for (const auto &e : snap)
+  {
+    if ((e.first != (*it).first) || (e.second != (*it).second))
+      return false ;
+    ++it ;
+  }
+  return true ;
+} // :: same
+
+void test_concurrent()
+{
+  Book  book ;
+  for (int i = 0; i < N_POSITIONS; i++)
+    book.insert( i * 2, 100.0 ) ;
+  const double  total = 100.0 * N_POSITIONS ;
+
+  std::atomic<bool>  done( false ) ;
+  std::atomic<int>   reports( 0 ) ;
+  int                torn    = 0 ;
+  std::thread  report( [&](){
+    while (!done.load())
+    {
+      auto    snap = book.snapshot() ;
+      double  sum  = 0 ;
+      for (const auto &e : *snap)
+        sum += e.second ;
+      if (fabs( sum - total ) > 1e-3)
+        torn++ ;
+      reports++ ;
+    }
+  }) ;
+
+  srand( 11 ) ;
+  auto  t0 = std::chrono::steady_clock::now() ;
+  int  b = 0 ;
+  for (; (b < N_BATCHES) || (reports < 20); b++)
+  {
+    if (b % 100 == 0)
+      std::this_thread::yield() ;
+    int     from = 2 * (rand() % N_POSITIONS) ;
+    int     to   = 2 * (rand() % N_POSITIONS) ;
+    double  amt  = (rand() % 100) / 4.0 ;
+    lock_guard<observables::LockFreeMutex>  sc( book.gate() ) ;
+    book.update( std::make_pair( from, book[ from ] - amt )) ;
+    book.update( std::make_pair( to, book[ to ] + amt )) ;
+  }
+  auto  us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  done = true ;
+  report.join() ;
+  printf( "concurrent  %d batches in %ld us while %d reports ran, torn %d %s \n", b, (long)us, reports.load(), torn,
+          (torn == 0) ? "" : "FAIL" ) ;
+} // :: test_concurrent
+
+void test_versions()
+{
+  Book  book ;
+  for (int i = 0; i < N_POSITIONS; i++)
+    book.insert( i * 2, (double)i ) ;
+
+  auto  s1 = book.snapshot() ;
+  printf( "versions    %ld entries in %ld pages, again the same version: %s \n", (long)s1->size(), (long)s1->pages(),
+          (book.snapshot() == s1) ? "yes" : "FAIL" ) ;
+
+  book.update( std::make_pair( 1000, -1.0 )) ;
+  auto  s2 = book.snapshot() ;
+  size_t  shared = 0 ;
+  for (size_t p = 0; p < s2->pages(); p++)
+    if ((p < s1->pages()) && (s2->page( p ) == s1->page( p )))
+      shared++ ;
+  printf( "versions    one update: v%ld sees %.0f, v%ld sees %.0f, %ld of %ld pages shared %s \n",
+          (long)s1->version(), s1->at( 1000 ), (long)s2->version(), s2->at( 1000 ), (long)shared, (long)s2->pages(),
+          ((s1->at( 1000 ) == 500) && (s2->at( 1000 ) == -1) && (shared + 1 == s2->pages())) ? "" : "FAIL" ) ;
+
+  // the copied page of the old version goes with its last snapshot
+  std::weak_ptr<const Book::snapshot_type::Page>  old ;
+  for (size_t p = 0; p < s1->pages(); p++)
+    if (s2->page( p ) != s1->page( p ))
+      old = s1->page( p ) ;
+  bool  alive = !old.expired() ;
+  s1.reset() ;
+  printf( "versions    old page alive while held: %s, freed with the snapshot: %s \n", alive ? "yes" : "FAIL",
+          old.expired() ? "yes" : "FAIL" ) ;
+
+  // inserts, erases and odd keys landing between pages
+  srand( 5 ) ;
+  std::map<int, double>  ref( book.begin(), book.end() ) ;
+  for (int round = 0; round < 20; round++)
+  {
+    for (int i = 0; i < 2000; i++)
+    {
+      int  k = rand() % (2 * N_POSITIONS + 100) - 50 ;
+      if (rand() % 3 == 0)
+      {
+        book.erase( k ) ;
+        ref.erase( k ) ;
+      }
+      else
+      {
+        book.update( std::make_pair( k, (double)round )) ;
+        ref[ k ] = round ;
+      }
+    }
+    auto  s = book.snapshot() ;
+    if (!same( *s, ref ) || (s->find( -1000 ) != nullptr) || (s->count( ref.begin()->first ) != 1))
+    {
+      printf( "versions    round %d differs FAIL \n", round ) ;
+      return ;
+    }
+  }
+  auto  s3 = book.snapshot() ;
+  printf( "versions    20 rounds of churn match, %ld entries in %ld pages \n", (long)s3->size(), (long)s3->pages() ) ;
+
+  book.reset( ref.begin(), ref.begin(), false ) ;
+  printf( "versions    after reset: %ld entries, held snapshot keeps %ld \n", (long)book.snapshot()->size(), (long)s3->size() ) ;
+} // :: test_versions
+
+void test_vector()
+{
+  observables::oVector<int>  v ;
+  for (int i = 0; i < 10000; i++)
+    v.push_back( i ) ;
+
+  auto  s1 = v.snapshot() ;
+  v.set( 5000, -1 ) ;
+  v.push_back( 10000 ) ;
+  auto  s2 = v.snapshot() ;
+  size_t  shared = 0 ;
+  for (size_t p = 0; p < s1->pages(); p++)
+    if (s2->page( p ) == s1->page( p ))
+      shared++ ;
+  printf( "vector      v1 [5000] = %d, v2 [5000] = %d, sizes %ld / %ld, %ld of %ld pages shared %s \n",
+          (*s1)[ 5000 ], (*s2)[ 5000 ], (long)s1->size(), (long)s2->size(), (long)shared, (long)s1->pages(),
+          (((*s1)[ 5000 ] == 5000) && ((*s2)[ 5000 ] == -1) && (shared + 2 == s1->pages())) ? "" : "FAIL" ) ;
+
+  // an erase shifts everything after it
+  v.erase( v.begin() + 100 ) ;
+  auto  s3 = v.snapshot() ;
+  bool  ok = (s3->size() == v.size()) ;
+  size_t  i = 0 ;
+  for (int x : *s3)
+    ok = ok && (x == v[ i++ ]) ;
+  printf( "vector      after erase: %s, first page shared %s \n", ok ? "matches" : "FAIL",
+          (s3->page( 0 ) != s2->page( 0 )) ? "no" : "yes" ) ;
+
+  // bulk erases and clear mark the pages once, not once per element
+  observables::oVector<int>  big ;
+  for (int i = 0; i < 500000; i++)
+    big.push_back( i ) ;
+  auto  s4 = big.snapshot() ;
+  auto  t0 = std::chrono::steady_clock::now() ;
+  big.erase( big.begin() + 1000, big.begin() + 251000 ) ;
+  auto  s5 = big.snapshot() ;
+  big.clear() ;
+  auto  s6 = big.snapshot() ;
+  auto  ms = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  printf( "vector      erase 250k and clear 250k under snapshots in %ld ms: sizes %ld / %ld / %ld, [1000] %d %s \n", (long)ms,
+          (long)s4->size(), (long)s5->size(), (long)s6->size(), (*s5)[ 1000 ],
+          ((s4->size() == 500000) && (s5->size() == 250000) && (s6->size() == 0) && ((*s5)[ 1000 ] == 251000)
+           && ((*s4)[ 1000 ] == 1000) && (s5->page( 0 ) == s4->page( 0 ))) ? "" : "FAIL" ) ;
+} // :: test_vector
+
+int main()
+{
+  test_concurrent() ;
+  test_versions() ;
+  test_vector() ;
+  return 0 ;
+} // :: main
@@ -111,6 +111,36 @@ void test_numerics_simple()
   printf( "\n" ) ;
 } // :: test_numerics_simple
 
+//-----------------------------------------------------------------------------
+//  trampoline test
+//
+//  a long chain  c[i+1] = c[i] + 1  would recurse once per link with the default
+//  dispatch.  trampolined subjects queue the downstream notification instead, so
+//  the cascade runs iteratively from the outermost setter
+//
+#define  CHAIN_LEN                100000
+
+boost::observables::Numeric< long >   *chain ;
+
+void test_numerics_trampoline()
+{
+  printf( "--[  trampoline test  ]--\n\n" ) ;
+
+  chain = new boost::observables::Numeric< long >[ CHAIN_LEN ] ;
+  for (uint32_t i = 0; i < CHAIN_LEN - 1; i++)
+  {
+    chain[i].valueCB().set_dispatch( boost::observables::DISPATCH_TRAMPOLINE ) ;
+    chain[i] << new observers::LambdaPoke( [i](){ chain[i+1] = chain[i] + (long) 1 ; } ) ;
+  }
+
+  chain[0] = 5 ;
+  printf( "chain[0]: %ld  chain[%ld]: %ld  queue high-water: %ld \n\n", 
+          (long)chain[0], (long)(CHAIN_LEN - 1), (long)chain[CHAIN_LEN - 1], 
+          (long)boost::observables::Subject::pendingHighwater() ) ;
+
+  delete [] chain ;
+} // :: test_numerics_trampoline
+
 //-----------------------------------------------------------------------------
 //  speed test
 //
@@ -199,6 +229,8 @@ int main()
 
   test_numerics_simple() ;
 
+  test_numerics_trampoline() ;
+
   test_numerics_performance() ;
   return 0 ;
 } // :: main
@@ -0,0 +1,85 @@
+/*
+  @file       simple_observable.cpp
+  @brief      main file for Observable<T> test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include "boost/observe/observable.hpp"
+
+#define  N_UPDATES     2000000
+
+//-----------------------------------------------------------------------------
+//
+//  a Quote (seqlock) written by one thread while another reads it and checks
+//  every read for tearing, then a string (shared) with a change watcher
+//
+using namespace boost ;
+
+struct Quote
+{
+  double    bid ;
+  double    ask ;
+  int64_t   size ;
+  int64_t   check ;      // bid + ask + size, to spot a torn read
+} ;
+
+void test_quote()
+{
+  observables::Observable< Quote >  q( Quote{ 0, 0, 0, 0 } ) ;
+  std::atomic<bool>                 done( false ) ;
+  uint64_t                          n_reads = 0 ;
+  uint64_t                          n_torn  = 0 ;
+
+  std::thread  reader( [&](){
+    while (!done)
+    {
+      Quote  v = q.get() ;
+      if ((int64_t)(v.bid + v.ask) + v.size != v.check)
+        n_torn++ ;
+      n_reads++ ;
+    }
+  }) ;
+  for (int64_t i = 1; i <= N_UPDATES; i++)
+    q = Quote{ (double)i, (double)(i + 1), i, 3 * i + 1 } ;
+  done = true ;
+  reader.join() ;
+
+  printf( "quote    seqlock %d   %ld writes, %ld reads, %ld torn, last size %ld \n", (int)observables::Observable< Quote >::SEQLOCK,
+          (long)N_UPDATES, (long)n_reads, (long)n_torn, (long)q.ptr()->size ) ;
+} // :: test_quote
+
+void test_string()
+{
+  observables::Observable< std::string >  name( "IBM" ) ;
+
+  name << new observers::Lambda( []( const std::vector<boost::any> &args ) {
+    printf( "name     %s -> %s \n", any_cast<const std::string *>( args[1] )->c_str(),
+                                    any_cast<const std::string *>( args[0] )->c_str() ) ;
+  }) ;
+  name = std::string( "International Business Machines" ) ;
+  name.modify( []( std::string &s ){ s += " Corp." ; } ) ;
+  printf( "name     seqlock %d   now '%s' \n", (int)observables::Observable< std::string >::SEQLOCK, name.get().c_str() ) ;
+
+  // a held ptr() is the value itself, shared rather than copied, and stays
+  // as it was across later writes
+  std::shared_ptr<const std::string>  held = name.ptr() ;
+  bool  shared = (held.get() == name.ptr().get()) ;
+  name = std::string( "IBM" ) ;
+  printf( "name     ptr() shared %s, held '%s' after the next write %s \n", shared ? "yes" : "no", held->c_str(),
+          (shared && (*held == "International Business Machines Corp.") && (*name.ptr() == "IBM")) ? "" : "FAIL" ) ;
+} // :: test_string
+
+int main()
+{
+  test_quote() ;
+  test_string() ;
+  return 0 ;
+} // :: main
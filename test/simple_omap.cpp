@@ -10,6 +10,8 @@
   file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 */
 #include <stdio.h>
+#include <strings.h>
+#include <thread>
 #include "boost/observe/omap.hpp"
 
 //-----------------------------------------------------------------------------
@@ -31,18 +33,122 @@ void on_insert( const std::vector<boost::any> &args )
   printf( "inserted: %2ld. %s \n", (*it).first, (*it).second.c_str() ) ;
 } // :: on_insert
 
+void on_update( const std::vector<boost::any> &args )
+{
+  oStringMap_iter  it = boost::any_cast< oStringMap_iter >( args[0] ) ;
+
+  printf( "updated : %2ld. %s \n", (*it).first, (*it).second.c_str() ) ;
+} // :: on_update
+
+// 10k observers, each scoped to one symbol, and one to a range of symbols:
+// a change wakes only the observers whose key it touches
+void test_watch()
+{
+  boost::observables::oMap< uint32_t, double >  px ;
+  int                                           n_key = 0, n_range = 0 ;
+
+  for (uint32_t sym = 0; sym < 10000; sym++)
+    px.watch( sym ) << new boost::observers::Lambda( [&n_key]( const std::vector<boost::any> & ){ n_key++ ; } ) ;
+  px.watch_range( 100, 199 ) << new boost::observers::Lambda( [&n_range]( const std::vector<boost::any> &args ){
+    if (boost::any_cast<boost::observables::ChangeKind>( args[1] ) == boost::observables::CHANGE_ERASE)
+      n_range += 1000 ;
+    else
+      n_range++ ;
+  }) ;
+
+  for (uint32_t sym = 0; sym < 1000; sym++)
+    px.insert( sym, 1.0 ) ;
+  for (uint32_t sym = 0; sym < 1000; sym++)
+    px.update( std::make_pair( sym, 2.0 )) ;
+  px.erase( 150 ) ;
+  px.unwatch( 3 ) ;
+  px.update( std::make_pair( 3, 3.0 )) ;
+  printf( "watch   : %d keyed, %d ranged notifications (expect 2001, 1200) \n", n_key, n_range ) ;
+} // :: test_watch
+
+// a map keyed case-blind: a watch on "ibm" is the watch on "IBM"
+struct NoCase
+{
+  bool operator()( const std::string &a, const std::string &b ) const { return strcasecmp( a.c_str(), b.c_str() ) < 0 ; }
+} ;
+
+void test_watch_nocase()
+{
+  boost::observables::oMap< std::string, double, NoCase >  px ;
+  int                                                      n_key = 0 ;
+
+  px.watch( "ibm" ) << new boost::observers::Lambda( [&n_key]( const std::vector<boost::any> & ){ n_key++ ; } ) ;
+  px.insert( "IBM", 1.0 ) ;
+  px.update( std::make_pair( std::string( "Ibm" ), 2.0 )) ;
+  printf( "nocase  : %d notifications on \"ibm\" %s \n", n_key, (n_key == 2) ? "" : "FAIL" ) ;
+} // :: test_watch_nocase
+
+// two threads moving two maps into each other take the gates in one order
+void test_cross_move()
+{
+  boost::observables::oMap< uint32_t, double >  a, b ;
+
+  a.insert( 1, 1.0 ) ;
+  std::thread  t( [&](){
+    for (int i = 0; i < 20000; i++)
+      a = std::move( b ) ;
+  }) ;
+  for (int i = 0; i < 20000; i++)
+    b = std::move( a ) ;
+  t.join() ;
+  printf( "move    : crossed moves finished, %ld entries left %s \n", (long)(a.size() + b.size()),
+          (a.size() + b.size() <= 1) ? "" : "FAIL" ) ;
+} // :: test_cross_move
+
+// bulk replacement fires resetCB once, on each side that lost its contents
+void test_reset()
+{
+  boost::observables::oMap< uint32_t, double >  a, b ;
+  int                                           n_a = 0, n_b = 0 ;
+
+  a.resetCB() << new boost::observers::Lambda( [&n_a]( const std::vector<boost::any> & ){ n_a++ ; } ) ;
+  b.resetCB() << new boost::observers::Lambda( [&n_b]( const std::vector<boost::any> & ){ n_b++ ; } ) ;
+  a.insert( 1, 1.0 ) ;
+  b.insert( 2, 2.0 ) ;
+  b.insert( 3, 3.0 ) ;
+  a = b ;
+  const boost::observables::oMap< uint32_t, double >  &self = a ;
+  a = self ;
+  bool  copied = (n_a == 1) && (a.size() == 2) && (a.find( 1 ) == a.end()) ;
+  boost::observables::oMap< uint32_t, double >  c( std::move( b )) ;
+  printf( "reset   : copy %d, self-copy kept %ld, moved-from %d, moved %ld %s \n", n_a, (long)a.size(), n_b, (long)c.size(),
+          (copied && (n_b == 1) && b.empty() && (c.size() == 2)) ? "" : "FAIL" ) ;
+} // :: test_reset
+
 int main()
 {
   boost::observables::oMap< uint32_t, std::string >  key ;
 
   key.postInsertCB() << new boost::observers::Lambda( on_insert ) ;
   key.preEraseCB  () << new boost::observers::Lambda( on_erase  ) ;
+  key.updateCB    () << new boost::observers::Lambda( on_update ) ;
  
   key.insert( 10, "fred"  ) ;
   key.insert(  5, "sally" ) ;
   key.insert( 15, "bob"   ) ;
   key.erase (  5 ) ;
   key.insert( 23, "sue"   ) ;
+  key.update( std::make_pair( 10, std::string( "frederick" ))) ;
+  key.insert_or_assign( 42, "zaphod" ) ;
+  key.try_emplace( 42, "ignored" ) ;
+  key.emplace( 7, "marvin" ) ;
+
+  boost::observables::oMap< uint32_t, std::string >  other ;
+  other.insert( key.extract( 15 )) ;       // moves the node, no reallocation
+  printf( "moved   : %2ld. %s \n", (long)(*other.begin()).first, (*other.begin()).second.c_str() ) ;
+
+  key.erase( key.begin(), key.find( 42 )) ;
+  printf( "left    : %ld entry \n", (long)key.size() ) ;
+
+  test_watch() ;
+  test_watch_nocase() ;
+  test_cross_move() ;
+  test_reset() ;
 
   return 0 ;
 } // :: main
@@ -0,0 +1,79 @@
+/*
+  @file       simple_omvector.cpp
+  @brief      main file for memory-mapped vector test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include "boost/observe/omvector.hpp"
+
+#define  N_TICKS       5000000
+#define  TICK_FILE     "simple_omvector.bin"
+
+//-----------------------------------------------------------------------------
+//
+//  append ticks to a mapped vector with an observer keeping a running volume,
+//  close it, reopen the file and check that everything came back
+//
+struct Tick
+{
+  uint64_t  ts ;
+  double    price ;
+  uint32_t  qty ;
+} ;
+
+typedef  boost::observables::oMappedVector< Tick >   TickStore ;
+
+double elapsed( std::chrono::steady_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: elapsed
+
+int main()
+{
+  uint64_t  volume = 0 ;
+
+  remove( TICK_FILE ) ;
+  {
+    TickStore  store( TICK_FILE ) ;
+
+    store.postInsertCB() << new boost::observers::Lambda( [&volume]( const std::vector<boost::any> &args ) {
+      volume += (*boost::any_cast<TickStore::iterator>( args[0] )).qty ;
+    }) ;
+
+    auto t0 = std::chrono::steady_clock::now() ;
+    for (uint32_t i = 0; i < N_TICKS; i++)
+      store.push_back( Tick{ i, 50.0 + (i % 1000) / 100.0, 1 + i % 10 } ) ;
+    printf( "appended  %ld ticks in %.3lf s   (capacity %ld, volume %ld) \n",
+            (long)store.size(), elapsed( t0 ), (long)store.capacity(), (long)volume ) ;
+  }
+
+  auto t0 = std::chrono::steady_clock::now() ;
+  TickStore  reopened( TICK_FILE ) ;
+  printf( "reopened  %ld ticks in %.6lf s \n", (long)reopened.size(), elapsed( t0 ) ) ;
+
+  reopened.advise( TickStore::ACCESS_SEQUENTIAL ) ;
+  uint64_t  check = 0 ;
+  for (TickStore::iterator it = reopened.begin(); it != reopened.end(); it++)
+    check += (*it).qty ;
+
+  reopened.erase( reopened.begin(), reopened.begin() + 10 ) ;
+  bool  ok = (check == volume) && (reopened.size() == N_TICKS - 10) && (reopened[0].ts == 10) ;
+  printf( "%s \n", ok ? "reopened state matches" : "FAIL.  reopened state differs" ) ;
+
+  // appending an element of the vector itself across a remap
+  reopened.resize( reopened.capacity(), Tick{ 77, 1.5, 3 } ) ;
+  Tick  last = reopened.back() ;
+  reopened.push_back( reopened.back() ) ;
+  ok = (reopened.size() > reopened.capacity() / 2) && (last.ts == 77) && (reopened.back().ts == 77) && (reopened.back().qty == 3) ;
+  printf( "%s \n", ok ? "self-append across a remap matches" : "FAIL.  self-append across a remap differs" ) ;
+
+  remove( TICK_FILE ) ;
+  return 0 ;
+} // :: main
@@ -44,6 +44,26 @@ int main()
   vec.pop_back () ;
   vec.push_back( "sue" ) ;
 
+  std::string  name( "margaret" ) ;
+  vec.push_back( std::move( name )) ;                  // moved, not copied
+  vec.emplace_back( 3, 'z' ) ;                         // constructed in place: "zzz"
+  vec.emplace( vec.begin(), "first" ) ;
+
+  boost::observables::oVector< std::string >  other ;
+  other.resetCB() << new boost::observers::LambdaPoke( [](){ printf( "reset   :  contents moved in \n" ) ; } ) ;
+  other = std::move( vec ) ;                           // storage swapped, no per-element callbacks
+  printf( "moved   :  %ld entries, %ld left behind \n", (long)other.size(), (long)vec.size() ) ;
+
+  // scoped to the first two slots: only changes there are reported
+  other.watch_range( 0, 1 ) << new boost::observers::Lambda( []( const std::vector<boost::any> &args ) {
+    oStringVec_iter  it = boost::any_cast< oStringVec_iter >( args[0] ) ;
+    printf( "slot 0-1:  %s %s \n", (boost::any_cast< boost::observables::ChangeKind >( args[1] ) == boost::observables::CHANGE_ERASE)
+                                    ? "leaving" : "arrived", (*it).c_str() ) ;
+  }) ;
+  other.push_back( "tail" ) ;                          // not reported by the watch
+  other.insert( other.begin() + 1, "second" ) ;
+  other.erase( other.begin()) ;
+
   return 0 ;
 } // :: main
 
@@ -0,0 +1,104 @@
+/*
+  @file       simple_ring.cpp
+  @brief      main file for RingSubject test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "boost/observe/ring.hpp"
+
+#define  N_TICKS       10000000
+
+//-----------------------------------------------------------------------------
+//
+//  one publisher, a 'journal' and a 'risk' consumer that both read each tick,
+//  and a 'position' consumer that runs after both of them on the same slot.
+//  each consumer has its own thread
+//
+struct Tick
+{
+  int64_t   qty ;
+  double    price ;
+} ;
+
+double elapsed( std::chrono::steady_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: elapsed
+
+template <class Wait>
+bool test_ring( const char *name )
+{
+  typedef  boost::observables::RingSubject< Tick, Wait >   Ring ;
+
+  Ring               ring( 4096 ) ;
+  std::atomic<bool>  running( true ) ;
+  int64_t            journal = 0, risk = 0, position = 0 ;
+  bool               ordered = true ;
+
+  typename Ring::Consumer  j = ring.consume( [&]( const Tick &t, int64_t, bool ){ journal += t.qty ; } ) ;
+  typename Ring::Consumer  r = ring.consume( [&]( const Tick &t, int64_t, bool ){ risk += t.qty ; } ) ;
+  typename Ring::Consumer  p = ring.consume( [&]( const Tick &t, int64_t seq, bool ){
+                                 if ((ring.sequence( j ) < seq) || (ring.sequence( r ) < seq))
+                                   ordered = false ;
+                                 position += t.qty ;
+                               }, { j, r } ) ;
+
+  std::thread  tj( [&](){ ring.run( j, running ) ; } ) ;
+  std::thread  tr( [&](){ ring.run( r, running ) ; } ) ;
+  std::thread  tp( [&](){ ring.run( p, running ) ; } ) ;
+
+  auto t0 = std::chrono::steady_clock::now() ;
+  for (int64_t i = 0; i < N_TICKS; i++)
+    ring.invoke( Tick{ i & 0xff, 50.0 } ) ;
+  while (ring.sequence( p ) != ring.cursor())
+    std::this_thread::yield() ;
+  double  dt = elapsed( t0 ) ;
+
+  running = false ;
+  tj.join() ;
+  tr.join() ;
+  tp.join() ;
+
+  int64_t  expect = 0 ;
+  for (int64_t i = 0; i < N_TICKS; i++)
+    expect += i & 0xff ;
+  bool  ok = ordered && (journal == expect) && (risk == expect) && (position == expect) ;
+  printf( "%-14s %ld ticks in %.3lf s   (%.1lf M/s)   %s \n", name, (long)N_TICKS, dt,
+          N_TICKS / dt / 1.0e6, ok ? "ok" : "FAIL" ) ;
+  return ok ;
+} // :: test_ring
+
+int main()
+{
+  if (std::thread::hardware_concurrency() >= 4)    // spinning needs a core per thread
+    test_ring< boost::observables::BusySpinWait >( "busy-spin" ) ;
+  test_ring< boost::observables::YieldingWait >( "yielding" ) ;
+  test_ring< boost::observables::BlockingWait >( "blocking" ) ;
+
+  // observers work too, with the Subject argument convention, and are
+  // deleted with the ring
+  int64_t               sum   = 0 ;
+  std::shared_ptr<int>  token = std::make_shared<int>( 0 ) ;
+  {
+    boost::observables::RingSubject< Tick >  ring( 16 ) ;
+    ring << new boost::observers::Lambda( [&sum, token]( const std::vector<boost::any> &args ) {
+      sum += boost::any_cast<const Tick *>( args[0] )->qty ;
+    }) ;
+    for (int64_t i = 0; i < 10; i++)
+    {
+      ring.invoke( Tick{ i, 1.0 } ) ;
+      ring.drain() ;
+    }
+  }
+  printf( "observer       %s \n", ((sum == 45) && (token.use_count() == 1)) ? "ok" : "FAIL" ) ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,92 @@
+/*
+  @file       simple_snapshot.cpp
+  @brief      main file for container snapshot/restore test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include "boost/observe/snapshot.hpp"
+
+#define  N_ENTRIES     1000000
+#define  SNAP_VECTOR_FILE  "simple_snapshot_vec.bin"
+#define  SNAP_MAP_FILE     "simple_snapshot_map.bin"
+
+//-----------------------------------------------------------------------------
+//
+//  save a vector and a map, restore them into fresh containers and check that
+//  only the single resetCB fired
+//
+struct Position
+{
+  int       qty ;
+  double    cost ;
+} ;
+
+double elapsed( std::chrono::steady_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: elapsed
+
+int main()
+{
+  boost::observables::oVector< double >           vec, vec2 ;
+  boost::observables::oMap< uint64_t, Position >  map, map2 ;
+  uint32_t                                        n_inserts = 0 ;
+  uint32_t                                        n_resets  = 0 ;
+
+  for (uint32_t i = 0; i < N_ENTRIES; i++)
+  {
+    vec.push_back( i * 0.5 ) ;
+    map[ (uint64_t)i * 7 ] = Position{ (int)i, i * 1.25 } ;
+  }
+
+  auto t0 = std::chrono::steady_clock::now() ;
+  boost::observables::save_snapshot( vec, SNAP_VECTOR_FILE ) ;
+  boost::observables::save_snapshot( map, SNAP_MAP_FILE ) ;
+  printf( "saved     %ld + %ld entries in %.3lf s \n", (long)vec.size(), (long)map.size(), elapsed( t0 ) ) ;
+
+  vec2.postInsertCB() << new boost::observers::LambdaPoke( [&n_inserts](){ n_inserts++ ; } ) ;
+  map2.postInsertCB() << new boost::observers::LambdaPoke( [&n_inserts](){ n_inserts++ ; } ) ;
+  vec2.resetCB()      << new boost::observers::LambdaPoke( [&n_resets](){ n_resets++ ; } ) ;
+  map2.resetCB()      << new boost::observers::LambdaPoke( [&n_resets](){ n_resets++ ; } ) ;
+
+  t0 = std::chrono::steady_clock::now() ;
+  boost::observables::restore_snapshot( vec2, SNAP_VECTOR_FILE ) ;
+  boost::observables::restore_snapshot( map2, SNAP_MAP_FILE ) ;
+  printf( "restored  %ld + %ld entries in %.3lf s   (%ld inserts notified, %ld resets) \n",
+          (long)vec2.size(), (long)map2.size(), elapsed( t0 ), (long)n_inserts, (long)n_resets ) ;
+
+  bool  ok = (vec.size() == vec2.size()) && (map.size() == map2.size()) && (n_inserts == 0) && (n_resets == 2) ;
+  for (size_t i = 0; ok && (i < vec.size()); i++)
+    ok = (vec[i] == vec2[i]) ;
+  for (auto it = map.begin(); ok && (it != map.end()); it++)
+    ok = ((*map2.find( (*it).first )).second.qty == (*it).second.qty) ;
+
+  bool  rejected = false ;
+  try
+  {
+    boost::observables::restore_snapshot( vec2, SNAP_MAP_FILE ) ;   // wrong element type
+  }
+  catch (boost::observables::BadSnapshot &)
+  {
+    rejected = true ;
+  }
+  printf( "%s \n", (ok && rejected) ? "restored state matches" : "FAIL.  restored state differs" ) ;
+
+  // single-threaded containers snapshot the same way
+  boost::observables::oMap< uint64_t, Position, std::less<uint64_t>, boost::observables::NullMutex >  local, local2 ;
+  local[ 3 ] = Position{ 3, 3.75 } ;
+  boost::observables::save_snapshot( local, SNAP_MAP_FILE ) ;
+  boost::observables::restore_snapshot( local2, SNAP_MAP_FILE ) ;
+  printf( "%s \n", ((local2.size() == 1) && ((*local2.find( 3 )).second.qty == 3)) ? "NullMutex map restored" : "FAIL.  NullMutex map differs" ) ;
+
+  remove( SNAP_VECTOR_FILE ) ;
+  remove( SNAP_MAP_FILE ) ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,121 @@
+/*
+  @file       simple_subscription.cpp
+  @brief      main file for SubscriptionMatrix test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "boost/observe/numerics.hpp"
+#include "boost/observe/subscription.hpp"
+
+#define  N_STOCKS       5000
+#define  N_PORTFOLIOS   100000
+#define  N_HOLDINGS     20          // stocks per portfolio
+
+//-----------------------------------------------------------------------------
+//
+//  5k stocks x 100k portfolios, 20 holdings each: 2M edges.  every portfolio
+//  keeps a value; a price change adds qty * delta to each holder through the
+//  matrix.  the ctx of an edge is the quantity held
+//
+using namespace boost ;
+
+typedef observables::SubscriptionMatrix< uint32_t >  Book ;
+
+int main()
+{
+  Book                           book ;
+  std::vector<double>            value( N_PORTFOLIOS, 0 ) ;
+  std::vector< observables::Numeric<double> >  price( N_STOCKS ) ;
+
+  srand( 7 ) ;
+  auto  t0 = std::chrono::steady_clock::now() ;
+  for (uint32_t p = 0; p < N_PORTFOLIOS; p++)
+  {
+    for (int h = 0; h < N_HOLDINGS; h++)
+      book.add( (uint32_t)(rand() % N_STOCKS), p, (uint32_t)(1 + rand() % 100) ) ;
+  }
+  book.compact() ;
+  auto  ms = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  printf( "built    %ld edges over %ld sources in %ld ms, %.1f bytes/edge (Observer per edge: ~%d) \n",
+          (long)book.edges(), (long)book.sources(), (long)ms, (double)book.bytes() / book.edges(),
+          (int)(sizeof(observers::MemberFunc<Book>) + sizeof(void*) + 16) ) ;
+
+  // one observer per stock instead of one per holding
+  for (uint32_t s = 0; s < N_STOCKS; s++)
+  {
+    price[s] = 100.0 ;
+    price[s] << book.observer( s, [&value]( uint32_t p, const uint32_t &qty, const std::vector<boost::any> &args ){
+      value[p] += qty * (any_cast<double>( args[0] ) - any_cast<double>( args[1] )) ;
+    }) ;
+  }
+
+  t0 = std::chrono::steady_clock::now() ;
+  for (int tick = 0; tick < 20; tick++)
+    for (uint32_t s = 0; s < N_STOCKS; s++)
+      price[s] += 0.01 ;
+  auto  us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  printf( "dispatch %d price changes in %ld us, %.2f ns/edge \n", 20 * N_STOCKS, (long)us,
+          1000.0 * (double)us / (20.0 * (double)book.edges()) ) ;
+
+  // every edge got 20 x 0.01 x qty: recompute portfolio 0 from scratch
+  double  expect = 0 ;
+  for (uint32_t s = 0; s < N_STOCKS; s++)
+    book.dispatch( s, [&]( uint32_t p, const uint32_t &qty ){ if (p == 0) expect += qty * 0.2 ; } ) ;
+  printf( "check    portfolio 0 = %.4f, expected %.4f %s \n", value[0], expect, (fabs( value[0] - expect ) < 1e-6) ? "" : "FAIL" ) ;
+
+  // batched churn: remove a portfolio, re-add an edge with a new ctx
+  size_t  before = book.edges() ;
+  size_t  n_rm   = book.remove_target( 0 ) ;
+  book.add( 1, 0, 500 ) ;
+  book.add( 1, 0, 5 ) ;                  // the later add wins
+  printf( "churn    removed %ld, tombstones %ld, pending %ld, edges %ld -> %ld \n", (long)n_rm, (long)book.tombstones(),
+          (long)book.pending(), (long)before, (long)book.edges() ) ;
+  uint32_t  seen = 0 ;
+  book.dispatch( 1, [&]( uint32_t p, const uint32_t &qty ){ if (p == 0) seen = qty ; } ) ;
+  printf( "churn    queued: portfolio 0 holds %u of stock 1 %s \n", seen, (seen == 5) ? "" : "FAIL" ) ;
+  book.compact() ;
+  seen = 0 ;
+  book.dispatch( 1, [&]( uint32_t p, const uint32_t &qty ){ if (p == 0) seen = qty ; } ) ;
+  printf( "churn    after compact: tombstones %ld, pending %ld, portfolio 0 holds %u of stock 1 %s \n",
+          (long)book.tombstones(), (long)book.pending(), seen,
+          ((book.tombstones() == 0) && (book.pending() == 0) && (seen == 5)) ? "" : "FAIL" ) ;
+  bool  r1 = book.remove( 1, 0 ) ;
+  bool  r2 = book.remove( 1, 0 ) ;
+  printf( "churn    remove( 1, 0 ) %d, again %d %s \n", (int)r1, (int)r2, (r1 && !r2) ? "" : "FAIL" ) ;
+
+  // re-adding across compactions updates the one edge in place
+  int  n_seen = 0 ;
+  book.add( 1, 0, 7 ) ;
+  book.dispatch( 1, [&]( uint32_t p, const uint32_t & ){ if (p == 0) n_seen++ ; } ) ;
+  book.add( 1, 0, 9 ) ;
+  book.add( 1, 1, 3 ) ;
+  n_seen = 0 ;
+  book.dispatch( 1, [&]( uint32_t p, const uint32_t &qty ){ if (p == 0) { n_seen++ ; seen = qty ; } } ) ;
+  printf( "churn    re-added edge seen %d time(s) holding %u %s \n", n_seen, seen, ((n_seen == 1) && (seen == 9)) ? "" : "FAIL" ) ;
+
+  // one add per dispatch: queued adds are walked, not merged into 2M edges each time
+  book.compact() ;
+  t0 = std::chrono::steady_clock::now() ;
+  size_t  n_new = 0 ;
+  for (uint32_t i = 0; i < 1000; i++)
+  {
+    book.add( 2, N_PORTFOLIOS + i, 1 ) ;
+    n_new += book.dispatch( 2, [&]( uint32_t, const uint32_t & ){} ) ;
+  }
+  us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  printf( "trickle  1000 add + dispatch in %ld us, pending %ld %s \n", (long)us, (long)book.pending(),
+          (book.pending() == 1000) ? "" : "FAIL" ) ;
+  bool  bad = book.add( 2, observables::SubscriptionMatrix< uint32_t >::DEAD, 1 ) ;
+  printf( "reject   target with bit 31 set: %s %s \n", bad ? "added" : "refused", bad ? "FAIL" : "" ) ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,105 @@
+/*
+  @file       simple_timeseries.cpp
+  @brief      main file for oTimeSeries test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "boost/observe/otimeseries.hpp"
+
+#define  N_TICKS       1000000
+#define  WINDOW        500
+
+//-----------------------------------------------------------------------------
+//
+//  a 500-tick window fed from a price Numeric, checked against a brute-force
+//  recomputation every so often; then a 5 minute VWAP on explicit timestamps
+//
+using namespace boost ;
+
+double elapsed( std::chrono::steady_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count() ;
+} // :: elapsed
+
+void test_tick_window()
+{
+  observables::Numeric< double >      price ;
+  observables::oTimeSeries< double >  series( WINDOW ) ;
+  std::vector<double>                 hist ;
+  uint32_t                            n_bad = 0 ;
+  uint32_t                            n_new_highs = 0 ;
+
+  series.attach( price ) ;
+  series.max() << new observers::LambdaPoke( [&n_new_highs](){ n_new_highs++ ; } ) ;
+
+  auto t0 = std::chrono::steady_clock::now() ;
+  for (uint32_t i = 0; i < N_TICKS; i++)
+  {
+    double  px = 100.0 + (rand() % 2001 - 1000) / 100.0 ;
+    if (px != (double)price)               // an unchanged price does not notify
+      hist.push_back( px ) ;
+    price = px ;
+
+    if ((i % 9973) == 0)
+    {
+      size_t  lo = (hist.size() > WINDOW) ? hist.size() - WINDOW : 0 ;
+      double  sum = 0, mn = 1e300, mx = -1e300 ;
+      for (size_t k = lo; k < hist.size(); k++)
+      {
+        sum += hist[k] ;
+        mn = std::min( mn, hist[k] ) ;
+        mx = std::max( mx, hist[k] ) ;
+      }
+      double  mean = sum / (hist.size() - lo) ;
+      double  var  = 0 ;
+      for (size_t k = lo; k < hist.size(); k++)
+        var += (hist[k] - mean) * (hist[k] - mean) ;
+      var /= (hist.size() - lo) ;
+
+      if ((fabs( mean - (double)series.mean()) > 1e-6) || (fabs( var - (double)series.variance()) > 1e-6) ||
+          (mn != (double)series.min()) || (mx != (double)series.max()))
+        n_bad++ ;
+    }
+  }
+  printf( "ticks   %ld in %.3lf s   mean %.4lf  sd %.4lf  min %.2lf  max %.2lf  ewma %.4lf  (%ld max changes)  %s \n",
+          (long)N_TICKS, elapsed( t0 ), (double)series.mean(), series.stddev(), (double)series.min(), (double)series.max(),
+          (double)series.ewma(), (long)n_new_highs, (n_bad == 0) ? "ok" : "FAIL" ) ;
+} // :: test_tick_window
+
+void test_vwap()
+{
+  const uint64_t                      MINUTE = 60ull * 1000000000ull ;
+  observables::oTimeSeries< double >  trades( 100000, 5 * MINUTE ) ;
+
+  // one trade a minute for 10 minutes: price i at quantity i
+  for (uint64_t i = 1; i <= 10; i++)
+    trades.push( (double)i, (double)i, i * MINUTE ) ;
+
+  // window holds minutes 6..10 (a sample exactly 5 minutes old has left): sum(i*i) / sum(i) = 330 / 40
+  printf( "vwap    %ld trades in window, vwap %.4lf  %s \n", (long)trades.size(), (double)trades.mean(),
+          (fabs( (double)trades.mean() - 330.0 / 40.0 ) < 1e-9) ? "ok" : "FAIL" ) ;
+
+  // a zero-quantity print first must not poison the window
+  observables::oTimeSeries< double >  prints( 16 ) ;
+  prints.push( 99.0, 0.0 ) ;
+  prints.push( 10.0, 1.0 ) ;
+  prints.push( 20.0, 3.0 ) ;
+  printf( "vwap    zero-weight first: vwap %.4lf  variance %.4lf  %s \n", (double)prints.mean(), (double)prints.variance(),
+          ((fabs( (double)prints.mean() - 17.5 ) < 1e-9) && (fabs( (double)prints.variance() - 18.75 ) < 1e-9)) ? "ok" : "FAIL" ) ;
+} // :: test_vwap
+
+int main()
+{
+  test_tick_window() ;
+  test_vwap() ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,79 @@
+/*
+  @file       simple_topics.cpp
+  @brief      main file for TopicBus test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "boost/observe/topicbus.hpp"
+
+#define  N_PUBLISH     1000000
+
+//-----------------------------------------------------------------------------
+//
+//  market data topics <asset>.<venue>.<symbol>.<kind>, a handful of wildcard
+//  subscribers, and a publish loop by interned id
+//
+using namespace boost ;
+
+typedef observables::TopicBus<>  Bus ;
+
+int main()
+{
+  Bus   bus ;
+  int   ibm = 0, trades = 0, nyse = 0, all_eq = 0, unmatched = 0 ;
+
+  bus.subscribe( "equities.*.IBM.*" )       << new observers::Lambda( [&]( const std::vector<boost::any> & ){ ibm++ ; } ) ;
+  bus.subscribe( "equities.*.*.trade" )     << new observers::Lambda( [&]( const std::vector<boost::any> & ){ trades++ ; } ) ;
+  bus.subscribe( "equities.NYSE.IBM.quote" ) << new observers::Lambda( [&]( const std::vector<boost::any> & ){ nyse++ ; } ) ;
+  bus.subscribe( "equities.*.*.*" )         << new observers::Lambda( [&]( const std::vector<boost::any> &args ){
+    all_eq++ ;
+    if (args.size() != 2)
+      printf( "FAIL: expected { topic, px } \n" ) ;
+  }) ;
+  bus.get_default() << new observers::Lambda( [&]( const std::vector<boost::any> & ){ unmatched++ ; } ) ;
+
+  const char  *topics[] = { "equities.NYSE.IBM.trade", "equities.NYSE.IBM.quote", "equities.LSE.IBM.trade",
+                            "equities.NYSE.AAPL.quote", "fx.EBS.EURUSD.quote", "equities.NYSE.IBM" } ;
+  for (const char *t : topics)
+    printf( "%-26s -> %ld subscribers \n", t, (long)bus.publish( t, { 100.0 } )) ;
+  printf( "counts    ibm %d, trades %d, nyse quote %d, equities %d, unmatched %d %s \n", ibm, trades, nyse, all_eq, unmatched,
+          ((ibm == 3) && (trades == 2) && (nyse == 1) && (all_eq == 4) && (unmatched == 2)) ? "" : "FAIL" ) ;
+
+  // repeated publishes by id hit the resolved list
+  uint32_t  id = bus.intern( "equities.NYSE.IBM.trade" ) ;
+  ibm = 0 ;
+  auto  t0 = std::chrono::steady_clock::now() ;
+  for (int i = 0; i < N_PUBLISH; i++)
+    bus.publish( id, { 100.0 } ) ;
+  auto  us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - t0 ).count() ;
+  printf( "publish   %d by id, %.1f ns each (3 subjects), ibm %d %s \n", N_PUBLISH, 1000.0 * us / N_PUBLISH, ibm,
+          (ibm == N_PUBLISH) ? "" : "FAIL" ) ;
+
+  // a subscription change invalidates; a handler unsubscribing itself is safe
+  uint64_t  e = bus.epoch() ;
+  bus.subscribe( "*.*.IBM.trade" ) << new observers::Lambda( [&]( const std::vector<boost::any> & ){
+    bus.unsubscribe( "*.*.IBM.trade" ) ;
+  }) ;
+  size_t  a = bus.publish( id, { 100.0 } ) ;
+  size_t  b = bus.publish( id, { 100.0 } ) ;
+  printf( "changes   epoch %ld -> %ld, %ld then %ld subscribers, %ld patterns %s \n", (long)e, (long)bus.epoch(), (long)a, (long)b,
+          (long)bus.patterns(), ((a == 4) && (b == 3) && (bus.patterns() == 4)) ? "" : "FAIL" ) ;
+  printf( "topics    %ld interned \n", (long)bus.topics() ) ;
+
+  // an id that was never interned
+  uint32_t  bogus = (uint32_t)bus.topics() + 1000 ;
+  unmatched = 0 ;
+  size_t  n = bus.publish( bogus, { 100.0 } ) ;
+  printf( "unknown   id %u: %ld subscribers, name \"%s\", unmatched %d %s \n", bogus, (long)n, bus.topic( bogus ).c_str(), unmatched,
+          ((n == 0) && bus.topic( bogus ).empty() && bus.subscribers( bogus ).empty() && (unmatched == 0)) ? "" : "FAIL" ) ;
+  return 0 ;
+} // :: main
@@ -0,0 +1,100 @@
+/*
+  @file       simple_wait.cpp
+  @brief      main file for Numeric blocking-wait test app
+
+  @author     Robert McInnis
+  @date       september 10, 2016
+  @par        copyright (c) 2016 Solid ICE Technologies, Inc.  All rights reserved.
+
+  Distributed under the Boost Software License, Version 1.0. (See accompanying
+  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "boost/observe/numerics.hpp"
+
+#define  N_ROUNDS      2000
+
+//-----------------------------------------------------------------------------
+//
+//  a thread blocked on a price, woken by each change (ping-pong with a
+//  second Numeric for the reply); a threshold wait with and without a
+//  timeout; and the cost of a write when nobody waits
+//
+using namespace boost ;
+
+typedef std::chrono::steady_clock  Clock ;
+
+long us_since( Clock::time_point t0 )
+{
+  return (long)std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - t0 ).count() ;
+} // :: us_since
+
+int main()
+{
+  observables::Numeric<int>  ping, pong ;
+
+  std::thread  t( [&](){
+    int  v = 0 ;
+    while ((v = ping.wait_for_change( v )) >= 0)
+      pong = v ;
+  }) ;
+  auto  t0 = Clock::now() ;
+  for (int i = 1; i <= N_ROUNDS; i++)
+  {
+    ping = i ;
+    if (pong.wait_for_change( i - 1 ) != i)
+    {
+      printf( "ping-pong FAIL at %d \n", i ) ;
+      break ;
+    }
+  }
+  long  us = us_since( t0 ) ;
+  ping = -1 ;
+  t.join() ;
+  printf( "ping-pong %d round trips, %.1f us each \n", N_ROUNDS, (double)us / N_ROUNDS ) ;
+
+  // threshold, crossed by a writer that is not watched by anyone else
+  observables::Numeric<double>  price ;
+  price = 100.0 ;
+  std::thread  w( [&](){
+    for (int i = 0; i < 50; i++)
+    {
+      std::this_thread::sleep_for( std::chrono::microseconds( 200 )) ;
+      price += 1.0 ;
+    }
+  }) ;
+  price.wait_until( []( double p ){ return p >= 120.0 ; } ) ;
+  printf( "threshold woke at %.0f %s \n", (double)price, ((double)price >= 120.0) ? "" : "FAIL" ) ;
+  w.join() ;
+
+  t0 = Clock::now() ;
+  bool  hit = price.wait_until( []( double p ){ return p < 0 ; }, std::chrono::milliseconds( 20 )) ;
+  us = us_since( t0 ) ;
+  printf( "timeout   returned %s after %ld ms, waiters left %u %s \n", hit ? "true" : "false", us / 1000,
+          observables::ParkingLot::instance().waiters( &price ), (!hit && (us >= 20000)) ? "" : "FAIL" ) ;
+
+  // a watcher that throws does not keep the waiters asleep
+  observables::Numeric<int>  q ;
+  q << new observers::Lambda( []( const std::vector<boost::any> & ){ throw 1 ; } ) ;
+  bool  woke = false ;
+  std::thread  r( [&](){ woke = q.wait_until( []( int v ){ return v != 0 ; }, std::chrono::seconds( 5 )) ; } ) ;
+  while (observables::ParkingLot::instance().waiters( &q ) == 0)
+    std::this_thread::yield() ;
+  t0 = Clock::now() ;
+  try { q = 1 ; } catch (int) {}
+  r.join() ;
+  us = us_since( t0 ) ;
+  printf( "throwing  watcher, waiter woke %s after %ld ms %s \n", woke ? "true" : "false", us / 1000,
+          (woke && (us < 1000000)) ? "" : "FAIL" ) ;
+
+  // nobody waiting: the write pays one load of its stripe
+  observables::Numeric<double>  x ;
+  t0 = Clock::now() ;
+  for (int i = 1; i <= 10000000; i++)
+    x = (double)i ;
+  printf( "writer    10M unwaited writes, %.2f ns each \n", 1000.0 * us_since( t0 ) / 10000000.0 ) ;
+  return 0 ;
+} // :: main